@@ -0,0 +1,62 @@
+/*  =========================================================================
+    bench/bench.h - helpers for micro benchmarks
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace bench {
+
+/// run fn iterations times and print average duration of one run
+template <typename Fn>
+double measure(const char* name, size_t iterations, Fn&& fn)
+{
+    // warm up caches and allocator
+    fn();
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i != iterations; i++) {
+        fn();
+    }
+    std::chrono::duration<double, std::milli> took = std::chrono::steady_clock::now() - start;
+
+    double per_run = took.count() / double(iterations);
+    printf("%-32s %12.3f ms/run (%zu runs)\n", name, per_run, iterations);
+    return per_run;
+}
+
+/// return argv[i] converted to number or dflt when not present
+inline size_t arg(int argc, char** argv, int i, size_t dflt)
+{
+    if (i >= argc) {
+        return dflt;
+    }
+    return size_t(::strtoul(argv[i], NULL, 10));
+}
+
+} // namespace bench
+
+int bench_csv(int argc, char** argv);
+int bench_csv_writer(int argc, char** argv);
+int bench_ext_attribute(int argc, char** argv);
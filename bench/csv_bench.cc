@@ -0,0 +1,111 @@
+/*  =========================================================================
+    bench/csv_bench.cc - csv import parsing: cxxtools vs shared::CsvDocument
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "bench.h"
+#include "shared/csv.h"
+#include <cxxtools/csvdeserializer.h>
+#include <sstream>
+#include <stdexcept>
+
+// inventory-like file: a title row, short names, a few quoted values with delimiters inside
+static std::string s_generate(size_t rows, size_t cols)
+{
+    std::string csv = "\xef\xbb\xbf";
+    for (size_t c = 0; c != cols; c++) {
+        csv += (c ? "," : "") + std::string("column.") + std::to_string(c);
+    }
+    csv += "\r\n";
+    for (size_t r = 0; r != rows; r++) {
+        for (size_t c = 0; c != cols; c++) {
+            if (c) {
+                csv += ',';
+            }
+            if (c % 10 == 9) {
+                csv += "\"value, \"\"" + std::to_string(r) + "\"\"\"";
+            } else if (c % 3 != 2) {
+                csv += "value-" + std::to_string(r) + "-" + std::to_string(c);
+            }
+        }
+        csv += "\r\n";
+    }
+    return csv;
+}
+
+// what CsvMap_from_istream did before
+static shared::CsvMap s_cxxtools(const std::string& csv)
+{
+    std::istringstream                    in{csv};
+    std::vector<std::vector<std::string>> data;
+    cxxtools::CsvDeserializer             deserializer(in);
+    deserializer.delimiter(shared::findDelimiter(in));
+    deserializer.readTitle(false);
+    deserializer.deserialize(data);
+    shared::CsvMap cm{data};
+    cm.deserialize();
+    return cm;
+}
+
+static shared::CsvMap s_document(const std::string& csv)
+{
+    std::istringstream in{csv};
+    return shared::CsvMap_from_istream(in);
+}
+
+// both parsers must agree before their speed is interesting
+static void s_check(const std::string& what, const std::string& csv)
+{
+    auto expected = s_cxxtools(csv);
+    auto actual   = s_document(csv);
+    if (expected.rows() != actual.rows() || expected.getTitles() != actual.getTitles()) {
+        throw std::runtime_error(what + ": parsers differ in shape");
+    }
+    for (size_t r = 0; r != expected.rows(); r++) {
+        for (const auto& title : expected.getTitles()) {
+            if (expected.get(r, title) != actual.get(r, title)) {
+                throw std::runtime_error(what + ": parsers differ on row " + std::to_string(r) + " column " + title);
+            }
+        }
+    }
+}
+
+int bench_csv(int argc, char** argv)
+{
+    size_t rows = bench::arg(argc, argv, 0, 30000);
+    size_t cols = bench::arg(argc, argv, 1, 100);
+    size_t runs = bench::arg(argc, argv, 2, 5);
+
+    std::string csv = s_generate(rows, cols);
+    printf("csv: %zu rows, %zu columns, %zu bytes\n", rows, cols, csv.size());
+
+    s_check("generated", csv);
+    // quoting rules beyond the generated file: apostrophes quote too, only the quote a value starts with closes it
+    s_check("single quoted", "name,value\n'a, b','it''s'\n'multi\nline',x\n");
+    s_check("mixed quotes", "name;value;note\n\"it's\";'say \"hi\"';O'Brien\n'x;y';\"a\"\"b\";\n");
+
+    double old_ms = bench::measure("cxxtools::CsvDeserializer", runs, [&csv]() {
+        s_cxxtools(csv);
+    });
+    double new_ms = bench::measure("shared::CsvDocument", runs, [&csv]() {
+        s_document(csv);
+    });
+    printf("speedup: %.1fx, %.1f MB/s\n", old_ms / new_ms, double(csv.size()) / 1024 / 1024 / (new_ms / 1000));
+    return 0;
+}
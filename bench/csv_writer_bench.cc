@@ -0,0 +1,137 @@
+/*  =========================================================================
+    bench/csv_writer_bench.cc - csv export writing: cxxtools vs shared::CsvWriter
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "bench.h"
+#include "shared/csv_writer.h"
+#include <atomic>
+#include <cxxtools/csvserializer.h>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+// allocations are counted for the whole binary, only differences around one run are reported
+static std::atomic<size_t> s_allocations{0};
+
+void* operator new(size_t size)
+{
+    ++s_allocations;
+    if (void* p = ::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    ::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    ::free(p);
+}
+
+// export-like rows: short names, empty cells, a few values which need quoting
+static std::vector<std::vector<std::string>> s_generate(size_t rows, size_t cols)
+{
+    std::vector<std::vector<std::string>> data(rows);
+    for (size_t r = 0; r != rows; r++) {
+        data[r].reserve(cols);
+        for (size_t c = 0; c != cols; c++) {
+            if (c % 10 == 9) {
+                data[r].push_back("value, \"" + std::to_string(r) + "\"");
+            } else if (c % 17 == 16) {
+                data[r].push_back("line\nbreak");
+            } else if (c % 3 != 2) {
+                data[r].push_back("value-" + std::to_string(r) + "-" + std::to_string(c));
+            } else {
+                data[r].push_back("");
+            }
+        }
+    }
+    return data;
+}
+
+// what LineCsvSerializer did before: one cxxtools serialization per row
+static void s_cxxtools(std::ostream& out, const std::vector<std::vector<std::string>>& data)
+{
+    cxxtools::CsvSerializer cs{out, NULL};
+    for (const auto& row : data) {
+        std::vector<std::vector<std::string>> aux{};
+        aux.push_back(row);
+        cs.serialize(aux);
+    }
+}
+
+static void s_writer(std::ostream& out, const std::vector<std::vector<std::string>>& data)
+{
+    shared::CsvWriter writer{out};
+    for (const auto& row : data) {
+        for (const auto& cell : row) {
+            writer.add(cell);
+        }
+        writer.endRow();
+    }
+    writer.flush();
+}
+
+int bench_csv_writer(int argc, char** argv)
+{
+    size_t rows = bench::arg(argc, argv, 0, 30000);
+    size_t cols = bench::arg(argc, argv, 1, 60);
+    size_t runs = bench::arg(argc, argv, 2, 5);
+
+    auto data = s_generate(rows, cols);
+    printf("csv: %zu rows, %zu columns\n", rows, cols);
+
+    // both writers must give the same bytes before their speed is interesting
+    size_t bytes = 0;
+    {
+        std::ostringstream expected, actual;
+        s_cxxtools(expected, data);
+        s_writer(actual, data);
+        if (expected.str() != actual.str()) {
+            throw std::runtime_error("writers differ");
+        }
+        bytes = actual.str().size();
+    }
+
+    auto allocations = [&data](void (*fn)(std::ostream&, const std::vector<std::vector<std::string>>&)) {
+        std::ostringstream out;
+        size_t             before = s_allocations;
+        fn(out, data);
+        return double(s_allocations - before) / double(data.size());
+    };
+    printf("allocations per row: cxxtools %.1f, shared::CsvWriter %.1f\n", allocations(s_cxxtools),
+        allocations(s_writer));
+
+    double old_ms = bench::measure("cxxtools::CsvSerializer", runs, [&data]() {
+        std::ostringstream out;
+        s_cxxtools(out, data);
+    });
+    double new_ms = bench::measure("shared::CsvWriter", runs, [&data]() {
+        std::ostringstream out;
+        s_writer(out, data);
+    });
+    printf("speedup: %.1fx, %.1f MB/s\n", old_ms / new_ms, double(bytes) / 1024 / 1024 / (new_ms / 1000));
+    return 0;
+}
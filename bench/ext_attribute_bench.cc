@@ -0,0 +1,138 @@
+/*  =========================================================================
+    bench/ext_attribute_bench.cc - ext attribute key classification: std::regex vs shared::classifyExtAttribute
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "bench.h"
+#include "shared/ext_attribute.h"
+#include <regex>
+#include <stdexcept>
+#include <vector>
+
+typedef std::vector<std::vector<std::string>> assets_t;
+
+// ext attribute keys of a pdu-like asset, plus keys close to the special ones which must stay "ext"
+static assets_t s_generate(size_t assets, size_t outlets)
+{
+    static const std::vector<std::string> COMMON = {"name", "model", "manufacturer", "serial_no", "u_size",
+        "location_type", "ip.1", "ip.2", "mac.1", "hostname.1", "fqdn.1", "ip.x", "outlet.label", "outlets.1.label",
+        "description", "max_power", "phases.output", "contact_email", "installation_date", "maintenance_due"};
+
+    assets_t data(assets);
+    for (size_t a = 0; a != assets; a++) {
+        data[a] = COMMON;
+        for (size_t o = 1; o <= outlets; o++) {
+            data[a].push_back("outlet." + std::to_string(o) + ".label");
+            data[a].push_back("outlet." + std::to_string(o) + ".group");
+            data[a].push_back("outlet." + std::to_string(o) + ".type");
+        }
+    }
+    return data;
+}
+
+// what getJsonAsset did before: regexes built for every asset, matched in turn, number copied out by substr
+static size_t s_regex(const assets_t& data, std::vector<shared::ExtAttributeKind>& kinds)
+{
+    size_t numbers = 0;
+    for (const auto& asset : data) {
+        std::regex r_outlet_label("^outlet\\.[0-9][0-9]*\\.label$");
+        std::regex r_outlet_group("^outlet\\.[0-9][0-9]*\\.group$");
+        std::regex r_outlet_type("^outlet\\.[0-9][0-9]*\\.type$");
+        std::regex r_ip("^ip\\.[0-9][0-9]*$");
+        std::regex r_mac("^mac\\.[0-9][0-9]*$");
+        std::regex r_hostname("^hostname\\.[0-9][0-9]*$");
+        std::regex r_fqdn("^fqdn\\.[0-9][0-9]*$");
+        for (const auto& key : asset) {
+            shared::ExtAttributeKind kind = shared::ExtAttributeKind::Other;
+            if (std::regex_match(key, r_outlet_label)) {
+                kind = shared::ExtAttributeKind::OutletLabel;
+            } else if (std::regex_match(key, r_outlet_group)) {
+                kind = shared::ExtAttributeKind::OutletGroup;
+            } else if (std::regex_match(key, r_outlet_type)) {
+                kind = shared::ExtAttributeKind::OutletType;
+            } else if (std::regex_match(key, r_ip)) {
+                kind = shared::ExtAttributeKind::Ip;
+            } else if (std::regex_match(key, r_mac)) {
+                kind = shared::ExtAttributeKind::Mac;
+            } else if (std::regex_match(key, r_fqdn)) {
+                kind = shared::ExtAttributeKind::Fqdn;
+            } else if (std::regex_match(key, r_hostname)) {
+                kind = shared::ExtAttributeKind::Hostname;
+            }
+            if (kind == shared::ExtAttributeKind::OutletLabel || kind == shared::ExtAttributeKind::OutletGroup ||
+                kind == shared::ExtAttributeKind::OutletType) {
+                std::string number = key.substr(key.find_first_of(".") + 1);
+                number             = number.substr(0, number.find_first_of("."));
+                numbers += number.size();
+            }
+            kinds.push_back(kind);
+        }
+    }
+    return numbers;
+}
+
+static size_t s_classifier(const assets_t& data, std::vector<shared::ExtAttributeKind>& kinds)
+{
+    size_t numbers = 0;
+    for (const auto& asset : data) {
+        for (const auto& key : asset) {
+            auto classified = shared::classifyExtAttribute(key);
+            if (classified.kind == shared::ExtAttributeKind::OutletLabel ||
+                classified.kind == shared::ExtAttributeKind::OutletGroup ||
+                classified.kind == shared::ExtAttributeKind::OutletType) {
+                numbers += classified.number.size();
+            }
+            kinds.push_back(classified.kind);
+        }
+    }
+    return numbers;
+}
+
+int bench_ext_attribute(int argc, char** argv)
+{
+    size_t assets  = bench::arg(argc, argv, 0, 2000);
+    size_t outlets = bench::arg(argc, argv, 1, 24);
+    size_t runs    = bench::arg(argc, argv, 2, 5);
+
+    auto   data       = s_generate(assets, outlets);
+    size_t attributes = assets * data[0].size();
+    printf("ext attributes: %zu assets, %zu keys each\n", assets, data[0].size());
+
+    // both must classify every key the same before their speed is interesting
+    {
+        std::vector<shared::ExtAttributeKind> expected, actual;
+        if (s_regex(data, expected) != s_classifier(data, actual) || expected != actual) {
+            throw std::runtime_error("classifiers differ");
+        }
+    }
+
+    std::vector<shared::ExtAttributeKind> kinds;
+    kinds.reserve(attributes);
+    double old_ms = bench::measure("std::regex", runs, [&]() {
+        kinds.clear();
+        s_regex(data, kinds);
+    });
+    double new_ms = bench::measure("shared::classifyExtAttribute", runs, [&]() {
+        kinds.clear();
+        s_classifier(data, kinds);
+    });
+    printf("per attribute: std::regex %.1f ns, shared::classifyExtAttribute %.1f ns, speedup %.1fx\n",
+        old_ms * 1e6 / double(attributes), new_ms * 1e6 / double(attributes), old_ms / new_ms);
+    return 0;
+}
@@ -0,0 +1,60 @@
+/*  =========================================================================
+    bench/main.cc - micro benchmarks of fty-rest hot paths
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "bench.h"
+#include <cstring>
+#include <iostream>
+
+static void s_usage()
+{
+    std::cerr << "Usage: fty-rest-bench <benchmark> [args]" << std::endl
+              << "       csv [rows] [cols] [runs]                csv import parsing, cxxtools vs shared::CsvDocument"
+              << std::endl
+              << "       csv-writer [rows] [cols] [runs]         csv export writing, cxxtools vs shared::CsvWriter"
+              << std::endl
+              << "       ext-attribute [assets] [outlets] [runs] ext attribute keys, std::regex vs classifier"
+              << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc <= 1) {
+        s_usage();
+        exit(EXIT_FAILURE);
+    }
+
+    try {
+        if (!strcmp(argv[1], "csv")) {
+            return bench_csv(argc - 2, argv + 2);
+        }
+        if (!strcmp(argv[1], "csv-writer")) {
+            return bench_csv_writer(argc - 2, argv + 2);
+        }
+        if (!strcmp(argv[1], "ext-attribute")) {
+            return bench_ext_attribute(argc - 2, argv + 2);
+        }
+        std::cerr << "Unknown benchmark '" << argv[1] << "'" << std::endl;
+        s_usage();
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+    }
+    exit(EXIT_FAILURE);
+}
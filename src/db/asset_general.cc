@@ -18,14 +18,24 @@
  *
  */
 
+#include "db/asset_general.h"
+#include "cleanup.h"
 #include "dbtypes.h"
+#include "persist/assetcrud.h"
+#include "persist/assetnames.h"
+#include "persist/assettree.h"
+#include "persist/rackcapacity.h"
+#include "shared/asset_json_cache.h"
 #include "shared/ic.h"
+#include "shared/sql_in.h"
 #include "shared/utilspp.h"
+#include <algorithm>
 #include <fty_asset_activator.h>
 #include <fty_common.h>
 #include <fty_common_db.h>
 #include <fty_common_macros.h>
 #include <fty_common_mlm_sync_client.h>
+#include <iterator>
 #include <locale.h>
 #include <tntdb/transaction.h>
 
@@ -35,6 +45,325 @@ namespace persist {
 
 static const char* ENV_OVERRIDE_LAST_DC_DELETION_CHECK = "FTY_OVERRIDE_LAST_DC_DELETION_CHECK";
 
+// collector of changes of this thread
+static thread_local DeferredChanges* s_deferred = NULL;
+
+/*
+ * \brief Re-reads assets into names and tree indexes, the tree is dropped if it can't be re-read
+ */
+static void s_reload(tntdb::Connection& conn, const std::vector<a_elmnt_id_t>& ids)
+{
+    AssetNames::reload(conn, ids);
+    AssetTree::instance().reload(conn, std::vector<uint32_t>(ids.begin(), ids.end()));
+}
+
+/*
+ * \brief Drops what process wide caches know about the assets, after they were written
+ */
+static void s_changed(tntdb::Connection& conn, const std::vector<a_elmnt_id_t>& ids)
+{
+    for (auto id : ids) {
+        shared::AssetJsonCache::instance().invalidate(id);
+        RackCapacity::instance().invalidate(id);
+    }
+    if (s_deferred) {
+        for (auto id : ids) {
+            s_deferred->add(id);
+        }
+        return;
+    }
+    s_reload(conn, ids);
+}
+
+static void s_changed(tntdb::Connection& conn, a_elmnt_id_t element_id)
+{
+    s_changed(conn, std::vector<a_elmnt_id_t>{element_id});
+}
+
+/*
+ * \brief Runs the statement for ids in chunks, every {ids} in it is replaced by the list of one chunk
+ */
+static void s_delete_in(tntdb::Connection& conn, const std::string& sql, const std::vector<a_elmnt_id_t>& ids)
+{
+    static const std::string IDS = "{ids}";
+    for (const auto& in : shared::sql_in_lists(ids)) {
+        std::string statement = sql;
+        for (size_t pos = statement.find(IDS); pos != std::string::npos; pos = statement.find(IDS, pos + in.size())) {
+            statement.replace(pos, IDS.size(), in);
+        }
+        conn.prepare(statement).execute();
+    }
+}
+
+DeferredChanges::DeferredChanges(tntdb::Connection& conn)
+    : _conn{conn}
+    , _ids{}
+    , _outer{s_deferred}
+{
+    s_deferred = this;
+}
+
+DeferredChanges::~DeferredChanges()
+{
+    s_deferred = _outer;
+    try {
+        flush();
+    } catch (const std::exception& e) {
+        log_error("cannot reload written assets: %s", e.what());
+        AssetTree::instance().invalidate_all();
+    }
+}
+
+void DeferredChanges::flush()
+{
+    if (_ids.empty()) {
+        return;
+    }
+    std::vector<a_elmnt_id_t> ids;
+    ids.swap(_ids);
+    s_reload(_conn, ids);
+}
+
+void DeferredChanges::add(a_elmnt_id_t id)
+{
+    _ids.push_back(id);
+    if (_ids.size() >= MAX_ASSETS) {
+        flush();
+    }
+}
+
+// update functions write only what differs from the current state in DB, unchanged asset is not written at all
+
+static std::map<std::string, std::string> s_zhash2map(zhash_t* hash)
+{
+    std::map<std::string, std::string> ret;
+    if (hash == NULL) {
+        return ret;
+    }
+    for (void* it = zhash_first(hash); it != NULL; it = zhash_next(hash)) {
+        ret.emplace(zhash_cursor(hash), static_cast<const char*>(it));
+    }
+    return ret;
+}
+
+static db_a_link_key_t s_link_key(const link_t& link)
+{
+    return db_a_link_key_t{
+        link.src, link.src_out == NULL ? "" : link.src_out, link.dest_in == NULL ? "" : link.dest_in, link.type};
+}
+
+static bool s_element_differs(
+    const db_a_elmnt_t& current,
+    const char*         element_name,
+    a_elmnt_id_t        parent_id,
+    const char*         status,
+    a_elmnt_pr_t        priority,
+    const std::string&  asset_tag)
+{
+    return current.name != element_name || current.parent_id != parent_id || current.status != status ||
+           current.priority != priority || current.asset_tag != asset_tag;
+}
+
+// read only ext attributes (update_ts, update_user) describe the update itself and are not compared
+static bool s_asset_differs(
+    const db_a_elmnt_state_t&                 current,
+    const char*                               element_name,
+    a_elmnt_id_t                              parent_id,
+    const std::map<std::string, std::string>& ext,
+    const char*                               status,
+    a_elmnt_pr_t                              priority,
+    std::set<a_elmnt_id_t> const&             groups,
+    const std::vector<link_t>*                links,
+    const std::string&                        asset_tag)
+{
+    if (s_element_differs(current.element, element_name, parent_id, status, priority, asset_tag) ||
+        current.element.ext != ext || current.groups != groups) {
+        return true;
+    }
+    if (links == NULL) {
+        return false;
+    }
+    std::set<db_a_link_key_t> requested;
+    for (const auto& one_link : *links) {
+        requested.insert(s_link_key(one_link));
+    }
+    return requested != current.links;
+}
+
+// deletes read-write attributes not requested any more, updates changed ones and inserts new ones
+static int s_update_ext_attributes(
+    tntdb::Connection&                        conn,
+    a_elmnt_id_t                              element_id,
+    const db_a_elmnt_state_t&                 current,
+    const std::map<std::string, std::string>& ext,
+    const std::map<std::string, std::string>& ext_ro,
+    std::string&                              errmsg)
+{
+    try {
+        tntdb::Statement st = conn.prepareCached(
+            " DELETE FROM"
+            "   t_bios_asset_ext_attributes"
+            " WHERE"
+            "   id_asset_element = :element AND keytag = :keytag AND read_only = 0");
+        for (const auto& it : current.element.ext) {
+            if (ext.count(it.first) == 0) {
+                st.set("element", element_id).set("keytag", it.first).execute();
+            }
+        }
+    } catch (const std::exception&) {
+        errmsg = TRANSLATE_ME("cannot erase old external attributes");
+        return 2;
+    }
+
+    for (bool read_only : {false, true}) {
+        _scoped_zhash_t* added = zhash_new();
+        zhash_autofree(added);
+        try {
+            tntdb::Statement st = conn.prepareCached(
+                " UPDATE"
+                "   t_bios_asset_ext_attributes"
+                " SET"
+                "   value = :value, read_only = :read_only"
+                " WHERE"
+                "   id_asset_element = :element AND keytag = :keytag");
+            for (const auto& it : read_only ? ext_ro : ext) {
+                auto rw = current.element.ext.find(it.first);
+                auto ro = current.ext_ro.find(it.first);
+                if (rw == current.element.ext.end() && ro == current.ext_ro.end()) {
+                    zhash_insert(added, it.first.c_str(), const_cast<char*>(it.second.c_str()));
+                } else if (
+                    (rw != current.element.ext.end() && (read_only || rw->second != it.second)) ||
+                    (ro != current.ext_ro.end() && (!read_only || ro->second != it.second))) {
+                    st.set("value", it.second)
+                        .set("read_only", read_only)
+                        .set("element", element_id)
+                        .set("keytag", it.first)
+                        .execute();
+                }
+            }
+        } catch (const std::exception& e) {
+            errmsg = JSONIFY(e.what());
+            return read_only ? 31 : 3;
+        }
+
+        if (zhash_size(added) != 0) {
+            auto ret = DBAssetsInsert::insert_into_asset_ext_attributes(conn, element_id, added, read_only, errmsg);
+            if (ret.status == 0) {
+                errmsg = JSONIFY(errmsg.c_str());
+                return read_only ? 31 : 3;
+            }
+        }
+    }
+    return 0;
+}
+
+static int s_update_groups(
+    tntdb::Connection&            conn,
+    a_elmnt_id_t                  element_id,
+    std::set<a_elmnt_id_t> const& current,
+    std::set<a_elmnt_id_t> const& groups,
+    std::string&                  errmsg)
+{
+    try {
+        tntdb::Statement st = conn.prepareCached(
+            " DELETE FROM"
+            "   t_bios_asset_group_relation"
+            " WHERE"
+            "   id_asset_element = :element AND id_asset_group = :group");
+        for (const auto& group_id : current) {
+            if (groups.count(group_id) == 0) {
+                st.set("element", element_id).set("group", group_id).execute();
+            }
+        }
+    } catch (const std::exception&) {
+        errmsg = TRANSLATE_ME("cannot remove element from old groups");
+        return 4;
+    }
+
+    std::set<a_elmnt_id_t> added;
+    std::set_difference(
+        groups.begin(), groups.end(), current.begin(), current.end(), std::inserter(added, added.end()));
+    if (!added.empty()) {
+        auto ret = DBAssetsInsert::insert_element_into_groups(conn, added, element_id);
+        if (ret.affected_rows != added.size()) {
+            errmsg = TRANSLATE_ME("cannot insert device into all specified groups");
+            return 5;
+        }
+    }
+    return 0;
+}
+
+static int s_update_links(
+    tntdb::Connection&               conn,
+    a_elmnt_id_t                     element_id,
+    std::set<db_a_link_key_t> const& current,
+    std::vector<link_t>&             links,
+    std::string&                     errmsg)
+{
+    // links don't have 'dest' defined - it was not known until now; we have to fix it
+    std::set<db_a_link_key_t> requested;
+    std::vector<link_t>       added;
+    for (auto& one_link : links) {
+        one_link.dest = element_id;
+        auto key      = s_link_key(one_link);
+        requested.insert(key);
+        if (current.count(key) == 0) {
+            added.push_back(one_link);
+        }
+    }
+
+    try {
+        tntdb::Statement st = conn.prepareCached(
+            " DELETE FROM"
+            "   t_bios_asset_link"
+            " WHERE"
+            "   id_asset_device_dest = :dest AND id_asset_device_src = :src AND id_asset_link_type = :type AND"
+            "   IFNULL(src_out, '') = :src_out AND IFNULL(dest_in, '') = :dest_in");
+        for (const auto& key : current) {
+            if (requested.count(key) == 0) {
+                st.set("dest", element_id)
+                    .set("src", std::get<0>(key))
+                    .set("src_out", std::get<1>(key))
+                    .set("dest_in", std::get<2>(key))
+                    .set("type", unsigned(std::get<3>(key)))
+                    .execute();
+            }
+        }
+    } catch (const std::exception&) {
+        errmsg = TRANSLATE_ME("cannot remove old power sources");
+        return 6;
+    }
+
+    if (!added.empty()) {
+        auto ret = DBAssetsInsert::insert_into_asset_links(conn, added);
+        if (ret.affected_rows != added.size()) {
+            errmsg = TRANSLATE_ME("cannot add new power sources");
+            return 7;
+        }
+    }
+    return 0;
+}
+
+bool is_asset_unchanged(
+    tntdb::Connection&            conn,
+    a_elmnt_id_t                  element_id,
+    const char*                   element_name,
+    a_elmnt_id_t                  parent_id,
+    zhash_t*                      extattributes,
+    const char*                   status,
+    a_elmnt_pr_t                  priority,
+    std::set<a_elmnt_id_t> const& groups,
+    const std::vector<link_t>*    links,
+    const std::string&            asset_tag)
+{
+    auto current = select_asset_element_state(conn, element_id);
+    if (current.status == 0) {
+        return false;
+    }
+    return !s_asset_differs(current.item, element_name, parent_id, s_zhash2map(extattributes), status, priority,
+        groups, links, asset_tag);
+}
+
 //=============================================================================
 // transaction is used
 int update_dc_room_row_rack_group(
@@ -63,60 +392,46 @@ int update_dc_room_row_rack_group(
         return 1;
     }
 
-
-    int ret1 = DBAssetsUpdate::
-        update_asset_element(conn, element_id, element_name, parent_id, status, priority, asset_tag.c_str(), affected_rows);
-
-    if ((ret1 != 0) && (affected_rows != 1)) {
+    auto current = select_asset_element_state(conn, element_id);
+    if (current.status == 0) {
         trans.rollback();
-        errmsg = TRANSLATE_ME("check  element name, location, status, priority, asset_tag");
+        errmsg = current.msg;
         log_error("end: %s", errmsg.c_str());
-        return 1;
+        return 8;
     }
 
-    auto ret2 = DBAssetsDelete::delete_asset_ext_attributes_with_ro(conn, element_id, false);
-    if (ret2.status == 0) {
+    auto ext = s_zhash2map(extattributes);
+    if (!s_asset_differs(current.item, element_name, parent_id, ext, status, priority, groups, NULL, asset_tag)) {
         trans.rollback();
-        errmsg = TRANSLATE_ME("cannot erase old external attributes");
-        log_error("end: %s", errmsg.c_str());
-        return 2;
+        log_debug("element %" PRIu32 " is unchanged", element_id);
+        LOG_END;
+        return 0;
     }
 
-    auto ret3 = DBAssetsInsert::insert_into_asset_ext_attributes(conn, element_id, extattributes, false, errmsg);
-    if (ret3.status == 0) {
-        trans.rollback();
-        errmsg = JSONIFY(errmsg.c_str());
-        log_error("end: %s", errmsg.c_str());
-        return 3;
-    }
+    if (s_element_differs(current.item.element, element_name, parent_id, status, priority, asset_tag)) {
+        int ret1 = DBAssetsUpdate::update_asset_element(
+            conn, element_id, element_name, parent_id, status, priority, asset_tag.c_str(), affected_rows);
 
-    if (extattributesRO != NULL) {
-        auto ret31 = DBAssetsInsert::insert_into_asset_ext_attributes(conn, element_id, extattributes, false, errmsg);
-        if (ret31.status == 0) {
+        if ((ret1 != 0) && (affected_rows != 1)) {
             trans.rollback();
-            errmsg = JSONIFY(errmsg.c_str());
+            errmsg = TRANSLATE_ME("check  element name, location, status, priority, asset_tag");
             log_error("end: %s", errmsg.c_str());
-            return 31;
+            return 1;
         }
     }
 
-    auto ret4 = DBAssetsDelete::delete_asset_element_from_asset_groups(conn, element_id);
-    if (ret4.status == 0) {
-        trans.rollback();
-        errmsg = TRANSLATE_ME("cannot remove element from old groups");
-        log_error("end: %s", errmsg.c_str());
-        return 4;
+    int ret = s_update_ext_attributes(conn, element_id, current.item, ext, s_zhash2map(extattributesRO), errmsg);
+    if (ret == 0) {
+        ret = s_update_groups(conn, element_id, current.item.groups, groups, errmsg);
     }
-
-    auto ret5 = DBAssetsInsert::insert_element_into_groups(conn, groups, element_id);
-    if ((ret5.status == 0) && (ret5.affected_rows != groups.size())) {
+    if (ret != 0) {
         trans.rollback();
-        errmsg = TRANSLATE_ME("cannot insert device into all specified groups");
         log_error("end: %s", errmsg.c_str());
-        return 5;
+        return ret;
     }
 
     trans.commit();
+    s_changed(conn, element_id);
     LOG_END;
     return 0;
 }
@@ -151,79 +466,52 @@ int update_device(
         return 1;
     }
 
-    int ret1 = DBAssetsUpdate::
-        update_asset_element(conn, element_id, element_name, parent_id, status, priority, asset_tag.c_str(), affected_rows);
-
-    if ((ret1 != 0) && (affected_rows != 1)) {
+    auto current = select_asset_element_state(conn, element_id);
+    if (current.status == 0) {
         trans.rollback();
-        errmsg = TRANSLATE_ME("check  element name, location, status, priority, asset_tag");
+        errmsg = current.msg;
         log_error("end: %s", errmsg.c_str());
-        return 1;
+        return 8;
     }
 
-    auto ret2 = DBAssetsDelete::delete_asset_ext_attributes_with_ro(conn, element_id, false);
-    if (ret2.status == 0) {
+    auto ext = s_zhash2map(extattributes);
+    if (!s_asset_differs(current.item, element_name, parent_id, ext, status, priority, groups, &links, asset_tag)) {
+        for (auto& one_link : links) {
+            one_link.dest = element_id;
+        }
         trans.rollback();
-        errmsg = TRANSLATE_ME("cannot erase old external attributes");
-        log_error("end: %s", errmsg.c_str());
-        return 2;
+        log_debug("element %" PRIu32 " is unchanged", element_id);
+        LOG_END;
+        return 0;
     }
 
-    auto ret3 = DBAssetsInsert::insert_into_asset_ext_attributes(conn, element_id, extattributes, false, errmsg);
-    if (ret3.status == 0) {
-        trans.rollback();
-        errmsg = JSONIFY(errmsg.c_str());
-        log_error("end: %s", errmsg.c_str());
-        return 3;
-    }
+    if (s_element_differs(current.item.element, element_name, parent_id, status, priority, asset_tag)) {
+        int ret1 = DBAssetsUpdate::update_asset_element(
+            conn, element_id, element_name, parent_id, status, priority, asset_tag.c_str(), affected_rows);
 
-    if (extattributesRO != NULL) {
-        auto ret31 = DBAssetsInsert::insert_into_asset_ext_attributes(conn, element_id, extattributesRO, true, errmsg);
-        if (ret31.status == 0) {
+        if ((ret1 != 0) && (affected_rows != 1)) {
             trans.rollback();
-            errmsg = JSONIFY(errmsg.c_str());
+            errmsg = TRANSLATE_ME("check  element name, location, status, priority, asset_tag");
             log_error("end: %s", errmsg.c_str());
-            return 31;
+            return 1;
         }
     }
 
-    auto ret4 = DBAssetsDelete::delete_asset_element_from_asset_groups(conn, element_id);
-    if (ret4.status == 0) {
-        trans.rollback();
-        errmsg = TRANSLATE_ME("cannot remove element from old groups");
-        log_error("end: %s", errmsg.c_str());
-        return 4;
-    }
-
-    auto ret5 = DBAssetsInsert::insert_element_into_groups(conn, groups, element_id);
-    if (ret5.affected_rows != groups.size()) {
-        trans.rollback();
-        errmsg = TRANSLATE_ME("cannot insert device into all specified groups");
-        log_error("end: %s", errmsg.c_str());
-        return 5;
-    }
-
-    // links don't have 'dest' defined - it was not known until now; we have to fix it
-    for (auto& one_link : links) {
-        one_link.dest = element_id;
+    int ret = s_update_ext_attributes(conn, element_id, current.item, ext, s_zhash2map(extattributesRO), errmsg);
+    if (ret == 0) {
+        ret = s_update_groups(conn, element_id, current.item.groups, groups, errmsg);
     }
-    auto ret6 = DBAssetsDelete::delete_asset_links_to(conn, element_id);
-    if (ret6.status == 0) {
-        trans.rollback();
-        errmsg = TRANSLATE_ME("cannot remove old power sources");
-        log_error("end: %s", errmsg.c_str());
-        return 6;
+    if (ret == 0) {
+        ret = s_update_links(conn, element_id, current.item.links, links, errmsg);
     }
-
-    auto ret7 = DBAssetsInsert::insert_into_asset_links(conn, links);
-    if (ret7.affected_rows != links.size()) {
+    if (ret != 0) {
         trans.rollback();
-        errmsg = TRANSLATE_ME("cannot add new power sources");
         log_error("end: %s", errmsg.c_str());
-        return 7;
+        return ret;
     }
 
     trans.commit();
+    s_changed(conn, element_id);
     LOG_END;
     return 0;
 }
@@ -329,6 +617,7 @@ db_reply_t insert_dc_room_row_rack_group(
     }
 
     trans.commit();
+    s_changed(conn, a_elmnt_id_t(reply_insert1.rowid));
     LOG_END;
     reply_insert1.msg = JSONIFY(reply_insert1.msg.c_str());
     return reply_insert1;
@@ -448,6 +737,7 @@ db_reply_t insert_device(
         return reply_select;
     }
     trans.commit();
+    s_changed(conn, a_elmnt_id_t(reply_insert1.rowid));
     LOG_END;
     reply_insert1.msg = JSONIFY(reply_insert1.msg.c_str());
     return reply_insert1;
@@ -459,7 +749,7 @@ db_reply_t delete_dc_room_row_rack(tntdb::Connection& conn, a_elmnt_id_t element
     tntdb::Transaction trans(conn);
 
     // Don't allow the deletion of the last datacenter (unless overriden)
-    if (getenv(ENV_OVERRIDE_LAST_DC_DELETION_CHECK) == nullptr) {
+    if (keep_last_datacenter()) {
         unsigned numDatacentersAfterDelete = conn.prepare(
                                                      " SELECT COUNT(id_asset_element)"
                                                      " FROM"
@@ -520,6 +810,7 @@ db_reply_t delete_dc_room_row_rack(tntdb::Connection& conn, a_elmnt_id_t element
     }
 
     trans.commit();
+    s_changed(conn, element_id);
     LOG_END;
     reply_delete4.msg = JSONIFY(reply_delete4.msg.c_str());
     return reply_delete4;
@@ -548,6 +839,7 @@ db_reply_t delete_group(tntdb::Connection& conn, a_elmnt_id_t element_id)
     }
 
     trans.commit();
+    s_changed(conn, element_id);
     LOG_END;
     reply_delete3.msg = JSONIFY(reply_delete3.msg.c_str());
     return reply_delete3;
@@ -592,6 +884,7 @@ db_reply_t delete_device(tntdb::Connection& conn, a_elmnt_id_t element_id, const
     }
 
     trans.commit();
+    s_changed(conn, element_id);
 
     // make the device inactive last
     if (!asset_json.empty()) {
@@ -616,4 +909,97 @@ db_reply_t delete_device(tntdb::Connection& conn, a_elmnt_id_t element_id, const
     return reply_delete6;
 }
 
+//=============================================================================
+std::map<a_elmnt_id_t, db_reply_t> delete_assets(tntdb::Connection& conn,
+    const std::vector<std::vector<a_elmnt_id_t>>& levels, const std::map<int64_t, std::string>& active_jsons)
+{
+    LOG_START;
+    std::map<a_elmnt_id_t, db_reply_t> ret;
+
+    std::vector<a_elmnt_id_t> ids;
+    for (const auto& level : levels) {
+        ids.insert(ids.end(), level.begin(), level.end());
+    }
+    if (ids.empty()) {
+        LOG_END;
+        return ret;
+    }
+
+    try {
+        tntdb::Transaction trans(conn);
+        s_delete_in(conn,
+            " DELETE FROM t_bios_asset_group_relation WHERE id_asset_element IN ({ids}) OR id_asset_group IN ({ids})",
+            ids);
+        s_delete_in(conn, " DELETE FROM t_bios_asset_link WHERE id_asset_device_dest IN ({ids})", ids);
+        s_delete_in(conn, " DELETE FROM t_bios_monitor_asset_relation WHERE id_asset_element IN ({ids})", ids);
+        // ext attributes go with their asset
+        for (const auto& level : levels) {
+            s_delete_in(conn, " DELETE FROM t_bios_asset_element WHERE id_asset_element IN ({ids})", level);
+        }
+        trans.commit();
+    } catch (const std::exception& e) {
+        // transaction is rolled back, nothing was deleted
+        log_error("end: error occured during removing %zu assets: %s", ids.size(), e.what());
+        for (auto id : ids) {
+            db_reply_t reply = db_reply_new();
+            reply.status     = 0;
+            reply.errtype    = DB_ERR;
+            reply.errsubtype = DB_ERROR_DELETEFAIL;
+            reply.msg        = JSONIFY(e.what());
+            ret[id]          = reply;
+        }
+        return ret;
+    }
+    s_changed(conn, ids);
+
+    for (auto id : ids) {
+        db_reply_t reply    = db_reply_new();
+        reply.status        = 1;
+        reply.affected_rows = 1;
+        reply.msg           = JSONIFY("");
+        ret[id]             = reply;
+    }
+
+    // make the devices inactive last
+    std::vector<a_elmnt_id_t> active;
+    for (auto id : ids) {
+        if (active_jsons.count(id) && !active_jsons.at(id).empty()) {
+            active.push_back(id);
+        }
+    }
+    if (!active.empty()) {
+        auto fail = [&ret](a_elmnt_id_t id, const std::exception& e) {
+            log_error("Error during asset deactivation - %s", e.what());
+            db_reply_t& reply = ret[id];
+            reply.status      = 0;
+            reply.errtype     = DB_ERR;
+            reply.errsubtype  = DB_ERROR_INTERNAL;
+            reply.msg         = e.what();
+        };
+        try {
+            mlm::MlmSyncClient  client(AGENT_FTY_ASSET, AGENT_ASSET_ACTIVATOR);
+            fty::AssetActivator activationAccessor(client);
+            for (auto id : active) {
+                try {
+                    activationAccessor.deactivate(active_jsons.at(id));
+                } catch (const std::exception& e) {
+                    fail(id, e);
+                }
+            }
+        } catch (const std::exception& e) {
+            for (auto id : active) {
+                fail(id, e);
+            }
+        }
+    }
+
+    LOG_END;
+    return ret;
+}
+
+bool keep_last_datacenter()
+{
+    return getenv(ENV_OVERRIDE_LAST_DC_DELETION_CHECK) == nullptr;
+}
+
 } // namespace persist
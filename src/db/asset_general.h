@@ -33,6 +33,59 @@
 
 namespace persist {
 
+/// @class DeferredChanges
+/// While it exists, assets written by insert, update and delete functions of this thread are collected and
+/// persist::AssetNames and persist::AssetTree re-read them together on flush(), not after every single write. Asset
+/// json and rack capacity are still invalidated right away. Meant for imports writing many assets one by one.
+class DeferredChanges
+{
+public:
+    /// collected assets are re-read once there is this many of them
+    static const size_t MAX_ASSETS = 256;
+
+    /// Starts collecting, collector of the thread existing before is resumed once this one is destroyed
+    ///
+    /// @param[in] conn - connection the assets are written and re-read over
+    explicit DeferredChanges(tntdb::Connection& conn);
+
+    DeferredChanges(const DeferredChanges&) = delete;
+    DeferredChanges& operator=(const DeferredChanges&) = delete;
+
+    /// Re-reads what is left and stops collecting
+    ~DeferredChanges();
+
+    /// Re-reads collected assets
+    void flush();
+
+    /// Collects written asset
+    void add(a_elmnt_id_t id);
+
+private:
+    tntdb::Connection&        _conn;
+    std::vector<a_elmnt_id_t> _ids;
+    DeferredChanges*          _outer;
+};
+
+
+/// Checks if the update with these values would change anything
+///
+/// Read only ext attributes (update_ts, update_user) describe the update itself and are not compared.
+/// @param[in] links - power links of device, NULL for other assets
+/// @return true if the asset in DB already has all the values, false if it differs or can't be read
+bool is_asset_unchanged(
+    tntdb::Connection&            conn,
+    a_elmnt_id_t                  element_id,
+    const char*                   element_name,
+    a_elmnt_id_t                  parent_id,
+    zhash_t*                      extattributes,
+    const char*                   status,
+    a_elmnt_pr_t                  priority,
+    std::set<a_elmnt_id_t> const& groups,
+    const std::vector<link_t>*    links,
+    const std::string&            asset_tag);
+
+
+/// Updates the asset, only values which differ from DB are written
 int update_dc_room_row_rack_group(
     tntdb::Connection&            conn,
     a_elmnt_id_t                  element_id,
@@ -48,6 +101,7 @@ int update_dc_room_row_rack_group(
     zhash_t*                      extattributesRO = NULL);
 
 
+/// Updates the device, only values and power links which differ from DB are written
 int update_device(
     tntdb::Connection&            conn,
     tntdb::Transaction&           trans,
@@ -103,4 +157,22 @@ db_reply_t delete_group(tntdb::Connection& conn, a_elmnt_id_t element_id);
 db_reply_t delete_device(tntdb::Connection& conn, a_elmnt_id_t element_id, const std::string& asset_json = "");
 
 
+/// Deletes validated assets of any type in one transaction
+///
+/// Nothing but the deleted assets themselves may contain the assets, be powered from them or refer to them. Groups,
+/// power links and monitor relations of all assets are removed by one statement each, assets of one level by one
+/// more, levels go in the given order so children are gone before their parents. Caches learn about all of them at
+/// once after commit, active devices are deactivated last over one client.
+///
+/// @param[in] levels       - ids in deletion order
+/// @param[in] active_jsons - json of every active device among them, rendered before deletion
+/// @return reply of every asset, all of them fail if the transaction fails
+std::map<a_elmnt_id_t, db_reply_t> delete_assets(tntdb::Connection& conn,
+    const std::vector<std::vector<a_elmnt_id_t>>& levels, const std::map<int64_t, std::string>& active_jsons);
+
+
+/// return if the last datacenter is protected from deletion, FTY_OVERRIDE_LAST_DC_DELETION_CHECK turns it off
+bool keep_last_datacenter();
+
+
 } // namespace persist
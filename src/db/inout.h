@@ -28,6 +28,7 @@
 #include "shared/csv.h"
 #include <fty_common.h>
 #include <fty_common_db.h>
+#include <functional>
 #include <iostream>
 #include <map>
 #include <stdexcept>
@@ -42,6 +43,7 @@ class MlmClient;
 
 namespace persist {
 
+/// called by csv import after every processed row, imported or rejected; exception thrown by it aborts the import
 typedef std::function<void(void)> touch_cb_t;
 
 /// Converts the string priority to number
@@ -64,10 +66,12 @@ std::pair<db_a_elmnt_t, persist::asset_operation> process_one_asset(const shared
 
 /// Processes a csv file
 ///
-/// Resuls are written in DB and into log.
+/// Resuls are written in DB and into log. Input bigger than 32 MiB which can tell its size (files, string streams)
+/// is imported by load_asset_csv_stream.
 ///
 /// @param[in]  input    - an input file
-/// @param[out] okRows   - a list of short information about inserted rows
+/// @param[out] okRows   - a list of short information about imported rows, one per row imported without issue;
+///                        rows equal to DB are included although nothing is written for them
 /// @param[out] failRows - a list of rejected rows with the message
 void load_asset_csv(
     std::istream&                                                   input,
@@ -76,12 +80,41 @@ void load_asset_csv(
     touch_cb_t                                                      touch_fn,
     std::string                                                     user = "");
 
+/// Processes a csv file row by row as it is read
+///
+/// Unlike load_asset_csv, the file is not loaded into memory as a whole. Rows are imported in the order of the file
+/// as soon as they are read. Only rows referring to an asset which is not known yet (e.g. their location is defined
+/// later in the file) are kept and imported once the asset is. Every chunk read at once is checked before any of its
+/// rows is written and new assets are written in batches, as by load_asset_csv. Resuls are written in DB and into
+/// log.
+///
+/// @param[in]  input    - an input file
+/// @param[out] okRows   - a list of short information about imported rows, one per row imported without issue;
+///                        rows equal to DB are included although nothing is written for them
+/// @param[out] failRows - a list of rejected rows with the message
+void load_asset_csv_stream(
+    std::istream&                                                   input,
+    std::vector<std::pair<db_a_elmnt_t, persist::asset_operation>>& okRows,
+    std::map<int, std::string>&                                     failRows,
+    touch_cb_t                                                      touch_fn,
+    std::string                                                     user = "");
+
+/// Checks a csv file without writing anything to DB (dry run)
+///
+/// Only checks which need no DB are done: names, types, subtypes, statuses, asset tags, dates and numeric ext
+/// attributes. Rows are checked in parallel, load_asset_csv runs the same checks before it writes anything.
+///
+/// @param[in]  input    - an input file
+/// @param[out] failRows - a list of rejected rows with the message
+void validate_asset_csv(std::istream& input, std::map<int, std::string>& failRows);
+
 /// Processes a csv map
 ///
 /// Resuls are written in DB and into log.
 ///
 /// @param[in]  cm       - an input csv map
-/// @param[out] okRows   - a list of short information about inserted rows
+/// @param[out] okRows   - a list of short information about imported rows, one per row imported without issue;
+///                        rows equal to DB are included although nothing is written for them
 /// @param[out] failRows - a list of rejected rows with the message
 void load_asset_csv(
     const shared::CsvMap&                                           cm,
@@ -94,7 +127,11 @@ void load_asset_csv(
 /// @param[out] out - a reference to the standard output stream to which content will be written
 /// @param[in] dc_id - limit export to this DC id (default -1 means all DCs)
 /// @param[in] generate_bom - generate BOM or not (default true)
-void export_asset_csv(std::ostream& out, int64_t dc_id = -1, bool generate_bom = true);
+/// @param[in] on_output - if set, called once all errors before the first row are excluded and output begins
+///                        (e.g. to switch the reply to direct mode), rows are written in chunks to the stream it
+///                        returns instead of out
+void export_asset_csv(std::ostream& out, int64_t dc_id = -1, bool generate_bom = true,
+    const std::function<std::ostream&()>& on_output = nullptr);
 
 void export_asset_json(std::ostream& out, std::set<std::string>* listElement = NULL);
 
@@ -24,12 +24,13 @@
 */
 
 #include "dbtypes.h"
-#include "shared/data.h"
+#include "persist/assetcrud.h"
+#include "shared/csv_writer.h"
+#include "shared/ext_attribute.h"
+#include "shared/sql_in.h"
 #include "shared/utilspp.h"
 #include <algorithm>
-#include <cxxtools/csvserializer.h>
 #include <cxxtools/jsonserializer.h>
-#include <cxxtools/regex.h>
 #include <fty_common.h>
 #include <fty_common_db_asset.h>
 #include <fty_common_db_dbpath.h>
@@ -38,6 +39,7 @@
 #include <iostream>
 #include <tntdb/row.h>
 #include <tntdb/transaction.h>
+#include <unordered_map>
 #include <vector>
 
 namespace persist {
@@ -65,59 +67,88 @@ static int s_update_keytags(tntdb::Connection& conn, const std::vector<std::stri
     return rv;
 }
 
-// using callbacks in cycle with maximum possible items might be difficult, so simply generate vector
-// for power links and print it inside the cycle
-//
-// at the same time I don't think this is general enough to be in src/db, so static functions here
 typedef std::vector<std::tuple<std::string, std::string, std::string>> power_links_t;
-static int s_power_links(tntdb::Connection& conn, a_elmnt_id_t id, power_links_t& out)
-{
-    row_cb_f foo = [&out](const tntdb::Row& r) {
-        std::string src_name{""};
-        std::string src_out{""};
-        std::string dest_in{""};
-        r["src_name"].get(src_name);
-        r["src_out"].get(src_out);
-        r["dest_in"].get(dest_in);
-        out.push_back(std::make_tuple(src_name, src_out, dest_in));
-    };
-    return DBAssets::select_v_web_asset_power_link_src_byId(conn, id, foo);
-}
 
-// helper class to assist with serialization line by line
-class LineCsvSerializer
+// all relations the export needs, each read by one query, so rows are produced from memory
+// instead of several queries per asset
+struct ExportIndex
 {
-public:
-    explicit LineCsvSerializer(std::ostream& out)
-        : _cs{out, NULL}
-        , _buf{}
+    std::unordered_map<a_elmnt_id_t, std::pair<std::string, std::string>>                 names; // name, ext name
+    std::unordered_map<std::string, std::string>                                          extnames;
+    std::unordered_map<a_elmnt_id_t, std::map<std::string, std::pair<std::string, bool>>> ext_attrs;
+    std::unordered_map<a_elmnt_id_t, power_links_t>                                       power_links;
+    std::unordered_map<a_elmnt_id_t, std::vector<std::string>>                            groups;
+
+    void load(tntdb::Connection& conn);
+
+    // same as DBAssets::id_to_name_ext_name, empty pair if not found
+    std::pair<std::string, std::string> id_to_name_ext_name(a_elmnt_id_t id) const
     {
+        auto it = names.find(id);
+        return it == names.end() ? std::pair<std::string, std::string>{} : it->second;
     }
 
-    void add(const std::string& s)
+    // same as DBAssets::name_to_extname, -1 if there is no such asset or it has no ext name
+    int name_to_extname(const std::string& name, std::string& extname) const
     {
-        _buf.push_back(s);
+        auto it = extnames.find(name);
+        if (it == extnames.end())
+            return -1;
+        extname = it->second;
+        return 0;
     }
+};
 
-    void add(const uint32_t i)
-    {
-        return add(std::to_string(i));
+void ExportIndex::load(tntdb::Connection& conn)
+{
+    auto reply = select_asset_element_names(conn);
+    if (reply.status == 0)
+        throw std::runtime_error(reply.msg.c_str());
+    for (auto& it : reply.item) {
+        if (!it.ext_name.empty())
+            extnames.emplace(it.name, it.ext_name);
+        names.emplace(it.id, std::make_pair(std::move(it.name), std::move(it.ext_name)));
     }
 
-    void serialize()
-    {
-        std::vector<std::vector<std::string>> aux{};
-        aux.push_back(_buf);
-        _cs.serialize(aux);
-        _buf.clear();
+    for (const auto& r : conn.prepare(" SELECT v.id_asset_element, v.keytag, v.value, v.read_only"
+                                      " FROM v_bios_asset_ext_attributes v")
+                             .select()) {
+        std::string keytag, value;
+        bool        read_only = false;
+        r[1].get(keytag);
+        r[2].get(value);
+        r[3].get(read_only);
+        ext_attrs[r.getUnsigned32(0)].emplace(keytag, std::make_pair(value, read_only));
     }
 
-protected:
-    cxxtools::CsvSerializer  _cs;
-    std::vector<std::string> _buf;
-};
+    // per asset order is the one DBAssets::select_v_web_asset_power_link_src_byId gives
+    for (const auto& r : conn.prepare(" SELECT v.id_asset_element_dest, v.src_name, v.src_out, v.dest_in"
+                                      " FROM v_web_asset_link v"
+                                      " WHERE v.id_asset_link_type = :linktype"
+                                      " ORDER BY v.id_asset_element_dest, v.id_link")
+                             .set("linktype", INPUT_POWER_CHAIN)
+                             .select()) {
+        std::string src_name{""};
+        std::string src_out{""};
+        std::string dest_in{""};
+        r[1].get(src_name);
+        r[2].get(src_out);
+        r[3].get(dest_in);
+        power_links[r.getUnsigned32(0)].push_back(std::make_tuple(src_name, src_out, dest_in));
+    }
 
-void export_asset_csv(std::ostream& out, int64_t dc_id, bool generate_bom)
+    // per asset order is the one DBAssets::select_group_names gives
+    for (const auto& r : conn.prepare(" SELECT r.id_asset_element, g.name"
+                                      " FROM t_bios_asset_group_relation r"
+                                      " JOIN t_bios_asset_element g ON g.id_asset_element = r.id_asset_group"
+                                      " ORDER BY r.id_asset_element, r.id_asset_group_relation")
+                             .select()) {
+        groups[r.getUnsigned32(0)].push_back(r.getString(1));
+    }
+}
+
+void export_asset_csv(
+    std::ostream& out, int64_t dc_id, bool generate_bom, const std::function<std::ostream&()>& on_output)
 {
     // 0.) tntdb connection
     tntdb::Connection conn;
@@ -131,11 +162,6 @@ void export_asset_csv(std::ostream& out, int64_t dc_id, bool generate_bom)
     }
     tntdb::Transaction transaction{conn, true};
 
-    if (generate_bom)
-        out << "\xef\xbb\xbf";
-
-    LineCsvSerializer lcs{out};
-
     // TODO: move somewhere else
     std::vector<std::string> KEYTAGS = {"description",
                                         "ip.1",
@@ -173,6 +199,23 @@ void export_asset_csv(std::ostream& out, int64_t dc_id, bool generate_bom)
     if (rv != 0)
         throw std::runtime_error(msg.c_str());
 
+    ExportIndex index;
+    try {
+        index.load(conn);
+    } catch (const std::exception& e) {
+        log_error("%s", e.what());
+        throw std::runtime_error(msg.c_str());
+    }
+
+    // everything which can fail before the first row is read, output begins on the stream given by the callback
+    std::ostream& os = on_output ? on_output() : out;
+
+    if (generate_bom)
+        os << "\xef\xbb\xbf";
+
+    // rows go to the stream in chunks as they are produced
+    shared::CsvWriter lcs{os};
+
     // 1 print the first row with names
     // 1.1      names from asset element table itself
     for (const auto& k : ASSET_ELEMENT_KEYTAGS) {
@@ -201,15 +244,18 @@ void export_asset_csv(std::ostream& out, int64_t dc_id, bool generate_bom)
     }
 
     lcs.add("id");
-    lcs.serialize();
+    lcs.endRow();
 
     // 2. FOR EACH ROW from v_web_asset_element / t_bios_asset_element do ...
-    std::function<void(const tntdb::Row&)> process_v_web_asset_element_row = [&conn, &lcs, &KEYTAGS, max_power_links,
+    std::function<void(const tntdb::Row&)> process_v_web_asset_element_row = [&index, &lcs, &KEYTAGS, max_power_links,
                                                                               max_groups, &msg](const tntdb::Row& r) {
+        static const power_links_t            NO_LINKS;
+        static const std::vector<std::string> NO_GROUPS;
+
         a_elmnt_id_t id_num = 0;
         std::string  id;
         r["id"].get(id_num);
-        std::pair<std::string, std::string> asset_names = DBAssets::id_to_name_ext_name(id_num);
+        std::pair<std::string, std::string> asset_names = index.id_to_name_ext_name(id_num);
         if (asset_names.first.empty() && asset_names.second.empty())
             throw std::runtime_error(msg.c_str());
         id = asset_names.first;
@@ -217,24 +263,22 @@ void export_asset_csv(std::ostream& out, int64_t dc_id, bool generate_bom)
         a_elmnt_id_t id_parent_num = 0;
         std::string  location;
         r["id_parent"].get(id_parent_num);
-        location = DBAssets::id_to_name_ext_name(id_parent_num).second;
+        location = index.id_to_name_ext_name(id_parent_num).second;
 
-        // 2.1      select all extended attributes
+        // 2.1      all extended attributes, copy as it is modified below
         std::map<std::string, std::pair<std::string, bool>> ext_attrs;
-        int rv1 = DBAssets::select_ext_attributes(conn, id_num, ext_attrs);
-        if (rv1 != 0)
-            throw std::runtime_error(msg.c_str());
+        {
+            auto it = index.ext_attrs.find(id_num);
+            if (it != index.ext_attrs.end())
+                ext_attrs = it->second;
+        }
 
         // 2.3 links
-        power_links_t power_links;
-        rv1 = s_power_links(conn, id_num, power_links);
-        if (rv1 != 0)
-            throw std::runtime_error(msg.c_str());
+        auto                 links_it    = index.power_links.find(id_num);
+        const power_links_t& power_links = links_it == index.power_links.end() ? NO_LINKS : links_it->second;
         // 3.4 groups
-        std::vector<std::string> groups;
-        rv1 = DBAssets::select_group_names(conn, id_num, groups);
-        if (rv1 != 0)
-            throw std::runtime_error(msg.c_str());
+        auto                            groups_it = index.groups.find(id_num);
+        const std::vector<std::string>& groups    = groups_it == index.groups.end() ? NO_GROUPS : groups_it->second;
 
         // 2.5      PRINT IT
         // 2.5.1    things from asset element table itself
@@ -284,7 +328,7 @@ void export_asset_csv(std::ostream& out, int64_t dc_id, bool generate_bom)
             if (i >= power_links.size()) {
                 // nothing here, exists only for consistency reasons
             } else {
-                int rv2 = DBAssets::name_to_extname(std::get<0>(power_links[i]), source);
+                int rv2 = index.name_to_extname(std::get<0>(power_links[i]), source);
                 if (rv2 != 0)
                     throw std::runtime_error(msg.c_str());
                 plug_src = std::get<1>(power_links[i]);
@@ -300,7 +344,7 @@ void export_asset_csv(std::ostream& out, int64_t dc_id, bool generate_bom)
             auto it = ext_attrs.find("logical_asset");
             if (it != ext_attrs.end()) {
                 std::string extname;
-                int         rv2 = DBAssets::name_to_extname(it->second.first, extname);
+                int         rv2 = index.name_to_extname(it->second.first, extname);
                 if (rv2 != 0)
                     throw std::runtime_error(msg.c_str());
                 ext_attrs["logical_asset"] = make_pair(extname, it->second.second);
@@ -321,7 +365,7 @@ void export_asset_csv(std::ostream& out, int64_t dc_id, bool generate_bom)
                 lcs.add("");
             else {
                 std::string extname;
-                int         rv2 = DBAssets::name_to_extname(groups[i], extname);
+                int         rv2 = index.name_to_extname(groups[i], extname);
                 if (rv2 != 0)
                     throw std::runtime_error(msg.c_str());
                 lcs.add(extname);
@@ -329,7 +373,7 @@ void export_asset_csv(std::ostream& out, int64_t dc_id, bool generate_bom)
         }
 
         lcs.add(id);
-        lcs.serialize();
+        lcs.endRow();
     };
 
     if (dc_id > 0) {
@@ -339,304 +383,325 @@ void export_asset_csv(std::ostream& out, int64_t dc_id, bool generate_bom)
     }
     if (rv != 0)
         throw std::runtime_error(msg.c_str());
+    lcs.flush();
     transaction.commit();
 }
 
-struct Outlet
+// ids of the assets with given names, ascending
+static std::vector<a_elmnt_id_t> s_select_ids(tntdb::Connection& conn, const std::set<std::string>& names)
 {
-    std::string label;
-    bool        label_r;
-    std::string type;
-    bool        type_r;
-    std::string group;
-    bool        group_r;
-};
-
-std::string getOutletNumber(const std::string& extAttributeName)
-{
-    auto        dot1    = extAttributeName.find_first_of(".");
-    std::string oNumber = extAttributeName.substr(dot1 + 1);
-    auto        dot2    = oNumber.find_first_of(".");
-    oNumber             = oNumber.substr(0, dot2);
-    return oNumber;
+    std::vector<a_elmnt_id_t> ret;
+    for (const auto& chunk : shared::sql_in_chunks(names)) {
+        tntdb::Statement st = conn.prepare(" SELECT v.id FROM v_bios_asset_element v"
+                                           " WHERE v.name IN (" + shared::sql_in_placeholders(chunk.size()) + ")");
+        shared::sql_in_bind(st, chunk);
+        for (const auto& r : st.select()) {
+            ret.push_back(r.getUnsigned32(0));
+        }
+    }
+    std::sort(ret.begin(), ret.end());
+    return ret;
 }
 
-void export_asset_json(std::ostream& out, std::set<std::string>* listElements)
+// external names of given assets, same as DBAssets::name_to_extname, assets without one are left out
+static std::map<std::string, std::string> s_select_extnames(
+    tntdb::Connection& conn, const std::set<std::string>& names)
 {
-    asset_manager asset_mgr;
-    // 0.) tntdb connection
-    tntdb::Connection conn;
-    std::string       msg{"no connection to database"};
-    try {
-        conn = tntdb::connect(DBConn::url);
-    } catch (...) {
-        log_error("%s", msg.c_str());
-        LOG_END;
-        throw std::runtime_error(msg.c_str());
+    std::map<std::string, std::string> ret;
+    if (names.empty()) {
+        return ret;
     }
-    tntdb::Transaction transaction{conn, true};
-
-    cxxtools::JsonSerializer serializer(out);
-
-    cxxtools::SerializationInfo si;
-    si.setCategory(cxxtools::SerializationInfo::Category::Array);
-    // 2. FOR EACH ROW from v_web_asset_element / t_bios_asset_element do ...
-    std::function<void(const tntdb::Row&)> process_v_web_asset_element_row_json = [&conn, &si, &msg, &asset_mgr,
-                                                                                   listElements](const tntdb::Row& r) {
-        a_elmnt_id_t id_num = 0;
-        std::string  id;
-        r["id"].get(id_num);
-        std::pair<std::string, std::string> asset_names = DBAssets::id_to_name_ext_name(id_num);
-        if (asset_names.first.empty() && asset_names.second.empty())
-            throw std::runtime_error(msg.c_str());
-        id = asset_names.first;
-
-        if (listElements == NULL || listElements->count(id) <= 0) {
-            return;
-        }
-        a_elmnt_id_t id_parent_num = 0;
-        std::string  location;
-        r["id_parent"].get(id_parent_num);
-        std::pair<std::string, std::string> location_names;
-        if (id_parent_num > 0) {
-            // Protect against invalid IDs.
-            location_names = DBAssets::id_to_name_ext_name(id_parent_num);
-        }
-        location                = location_names.second;
-        std::string location_id = location_names.first;
+    std::vector<std::string> list{names.begin(), names.end()};
+    tntdb::Statement         st = conn.prepare(
+        " SELECT a.name, e.value"
+        " FROM t_bios_asset_element a"
+        " JOIN t_bios_asset_ext_attributes e ON e.id_asset_element = a.id_asset_element AND e.keytag = 'name'"
+        " WHERE a.name IN (" + shared::sql_in_placeholders(list.size()) + ")");
+    shared::sql_in_bind(st, list);
+    for (const auto& r : st.select()) {
+        ret.emplace(r.getString(0), r.getString(1));
+    }
+    return ret;
+}
 
-        // 2.1      select all extended attributes
-        std::map<std::string, std::pair<std::string, bool>> ext_attrs;
-        int rv = DBAssets::select_ext_attributes(conn, id_num, ext_attrs);
-        if (rv != 0)
-            throw std::runtime_error(msg.c_str());
+// power link of json export: source name and external name, outlets
+struct JsonPowerLink
+{
+    std::string src_name;
+    std::string src_extname;
+    std::string src_out;
+    std::string dest_in;
+};
 
-        // 2.3 links
-        power_links_t power_links;
-        rv = s_power_links(conn, id_num, power_links);
-        if (rv != 0)
-            throw std::runtime_error(msg.c_str());
-        // 3.4 groups
-        std::vector<std::string> groups;
-        rv = DBAssets::select_group_names(conn, id_num, groups);
-        if (rv != 0)
-            throw std::runtime_error(msg.c_str());
+// print one asset of json export, ORDER of members IS SIGNIFICANT
+static void s_print_json_asset(
+    std::ostream&                                        out,
+    const tntdb::Row&                                    r,
+    std::map<std::string, std::pair<std::string, bool>>& ext_attrs,
+    const std::vector<JsonPowerLink>&                    power_links,
+    const std::map<std::string, std::string>&            extnames,
+    const std::string&                                   msg)
+{
+    std::string id;
+    r["name"].get(id);
+    std::string ext_name;
+    r["ext_name"].get(ext_name);
+
+    a_elmnt_id_t id_parent_num = 0;
+    r["id_parent"].get(id_parent_num);
+    std::string location;
+    std::string location_id;
+    std::string location_type;
+    if (id_parent_num > 0) {
+        r["parent_ext_name"].get(location);
+        r["parent_name"].get(location_id);
+        r["parent_type_name"].get(location_type);
+    }
 
-        cxxtools::SerializationInfo& si_asset = si.addMember("");
-        // 2.5      PRINT IT
-        // 2.5.1    things from asset element table itself
-        // ORDER of fields added to the lcs IS SIGNIFICANT
-        std::string type_name;
-        {
-            si_asset.addMember("id") <<= id;
-            si_asset.addMember("power_devices_in_uri") <<=
-                "/api/v1/assets?in=" + id + "&sub_type=epdu,pdu,feed,genset,ups,sts,rackcontroller";
-            si_asset.addMember("name") <<= asset_names.second;
+    cxxtools::SerializationInfo si_asset;
+    // 2.5.1    things from asset element table itself
+    std::string type_name;
+    {
+        si_asset.addMember("id") <<= id;
+        si_asset.addMember("power_devices_in_uri") <<=
+            "/api/v1/assets?in=" + id + "&sub_type=epdu,pdu,feed,genset,ups,sts,rackcontroller";
+        si_asset.addMember("name") <<= ext_name;
 
-            std::string status;
-            r["status"].get(status);
-            si_asset.addMember("status") <<= status;
+        std::string status;
+        r["status"].get(status);
+        si_asset.addMember("status") <<= status;
 
-            uint32_t priority;
-            r["priority"].get(priority);
-            si_asset.addMember("priority") <<= ("P" + std::to_string(priority));
+        uint32_t priority = 0;
+        r["priority"].get(priority);
+        si_asset.addMember("priority") <<= ("P" + std::to_string(priority));
 
-            r["type_name"].get(type_name);
-            si_asset.addMember("type") <<= type_name;
+        r["type_name"].get(type_name);
+        si_asset.addMember("type") <<= type_name;
 
-            if (!location.empty()) {
-                si_asset.addMember("location_uri") <<= "/api/v1/asset/" + location_id;
-                si_asset.addMember("location_id") <<= location_id;
+        if (!location.empty()) {
+            si_asset.addMember("location_uri") <<= "/api/v1/asset/" + location_id;
+            si_asset.addMember("location_id") <<= location_id;
+        }
+        si_asset.addMember("location") <<= location;
+        si_asset.addMember("location_type") <<= location_type;
+
+        // TODO : groups
+        cxxtools::SerializationInfo& si_asset_groups = si_asset.addMember("groups");
+        si_asset_groups.setCategory(cxxtools::SerializationInfo::Category::Array);
+
+        std::string subtype_name = "";
+        // subtype for groups is stored as ext/type
+        if (type_name == "group") {
+            if (ext_attrs.count("type") == 1) {
+                subtype_name = ext_attrs["type"].first;
+                ext_attrs.erase("type");
             }
-            si_asset.addMember("location") <<= location;
+        } else {
+            r["subtype_name"].get(subtype_name);
+        }
+        if (subtype_name == "N_A")
+            subtype_name = "";
 
-            if (id_parent_num > 0) {
-                auto parentAsset = asset_mgr.get_item1(id_parent_num);
-                si_asset.addMember("location_type") <<= parentAsset.item.basic.type_name;
-            } else {
-                si_asset.addMember("location_type") <<= "";
-            }
+        si_asset.addMember("sub_type") <<= utils::strip(subtype_name);
+    }
 
-            // TODO : groups
-            cxxtools::SerializationInfo& si_asset_groups = si_asset.addMember("groups");
-            si_asset_groups.setCategory(cxxtools::SerializationInfo::Category::Array);
-            /*
-            // 2.5.4        groups
-            for (uint32_t i = 0; i != groups.size(); i++) {
-                if (i >= groups.size())
-                    lcs.add("");
-                else {
-                    std::string extname;
-                    int rv = DBAssets::name_to_extname (groups[i], extname);
-                    if (rv != 0)
-                        throw std::runtime_error(msg.c_str());
-                    lcs.add(extname);
-                }
-            }
-    */
-            std::string subtype_name = "";
-            // subtype for groups is stored as ext/type
-            if (type_name == "group") {
-                if (ext_attrs.count("type") == 1) {
-                    subtype_name = ext_attrs["type"].first;
-                    ext_attrs.erase("type");
-                }
-            } else {
-                r["subtype_name"].get(subtype_name);
-            }
-            if (subtype_name == "N_A")
-                subtype_name = "";
+    // TODO : Parents
+    cxxtools::SerializationInfo& si_asset_parents = si_asset.addMember("parents");
+    si_asset_parents.setCategory(cxxtools::SerializationInfo::Category::Array);
+
+    // 2.5.2        power location
+    cxxtools::SerializationInfo& si_asset_powers = si_asset.addMember("powers");
+    si_asset_powers.setCategory(cxxtools::SerializationInfo::Category::Array);
+    for (const auto& link : power_links) {
+        cxxtools::SerializationInfo& si_power = si_asset_powers.addMember("");
+        si_power.addMember("src_name") <<= link.src_extname;
+        si_power.addMember("src_id") <<= link.src_name;
+        si_power.addMember("src_socket") <<= link.src_out;
+        si_power.addMember("dest_socket") <<= link.dest_in;
+    }
 
-            si_asset.addMember("sub_type") <<= utils::strip(subtype_name);
+    // convert necessary ids to names, for now just logical_asset
+    {
+        auto it = ext_attrs.find("logical_asset");
+        if (it != ext_attrs.end()) {
+            auto extname = extnames.find(it->second.first);
+            if (extname == extnames.end())
+                throw std::runtime_error(msg.c_str());
+            ext_attrs["logical_asset"] = make_pair(extname->second, it->second.second);
         }
+    }
 
-        // TODO : Parents
-        cxxtools::SerializationInfo& si_asset_parents = si_asset.addMember("parents");
-        si_asset_parents.setCategory(cxxtools::SerializationInfo::Category::Array);
-
-        // 2.5.2        power location
-        cxxtools::SerializationInfo& si_asset_powers = si_asset.addMember("powers");
-        si_asset_powers.setCategory(cxxtools::SerializationInfo::Category::Array);
-        for (uint32_t i = 0; i != power_links.size(); i++) {
-            cxxtools::SerializationInfo& si_power = si_asset_powers.addMember("");
-            std::string                  source{""};
-            std::string                  plug_src{""};
-            std::string                  input{""};
+    // 2.5.3        extended attributes
+    cxxtools::SerializationInfo& si_asset_ext_list = si_asset.addMember("ext");
+    si_asset_ext_list.setCategory(cxxtools::SerializationInfo::Category::Array);
 
-            if (i >= power_links.size()) {
-                // nothing here, exists only for consistency reasons
-            } else {
-                int rv1 = DBAssets::name_to_extname(std::get<0>(power_links[i]), source);
-                if (rv1 != 0)
-                    throw std::runtime_error(msg.c_str());
-                plug_src = std::get<1>(power_links[i]);
-                input    = std::get<2>(power_links[i]);
-            }
-            si_power.addMember("src_name") <<= source;
-            si_power.addMember("src_id") <<= std::get<0>(power_links[i]);
-            si_power.addMember("src_socket") <<= plug_src;
-            si_power.addMember("dest_socket") <<= input;
-        }
+    std::string asset_tag;
+    r["asset_tag"].get(asset_tag);
+    if (!asset_tag.empty()) {
+        cxxtools::SerializationInfo& si_ext_asset_tag = si_asset_ext_list.addMember("");
+        si_ext_asset_tag.addMember("asset_tag") <<= asset_tag;
+        si_ext_asset_tag.addMember("read_only") <<= false;
+    }
 
-        // convert necessary ids to names, for now just logical_asset
-        {
-            auto it = ext_attrs.find("logical_asset");
-            if (it != ext_attrs.end()) {
-                std::string extname;
-                int         rv1 = DBAssets::name_to_extname(it->second.first, extname);
-                if (rv1 != 0)
-                    throw std::runtime_error(msg.c_str());
-                ext_attrs["logical_asset"] = make_pair(extname, it->second.second);
+    std::string     t_ip("ip.");
+    shared::Outlets outlets;
+
+    // Print extended attributes
+    for (const auto& k : ext_attrs) {
+        if (k.first != "name" && (k.first.compare(0, t_ip.length(), t_ip) != 0)) {
+            // filter location_type (already present)
+            if (k.first == "location_type")
+                continue;
+
+            // We don't want info use in outlets
+            auto key = shared::classifyExtAttribute(k.first);
+            if (key.kind == shared::ExtAttributeKind::OutletLabel ||
+                key.kind == shared::ExtAttributeKind::OutletGroup ||
+                key.kind == shared::ExtAttributeKind::OutletType) {
+                shared::addOutletAttribute(outlets, key, k.second.first, k.second.second);
+                continue;
             }
+            // print valid info
+            cxxtools::SerializationInfo& si_ext_obj = si_asset_ext_list.addMember("");
+            si_ext_obj.addMember(k.first) <<= k.second.first;
+            si_ext_obj.addMember("read_only") <<= k.second.second;
         }
+    }
 
-        // 2.5.3        extended attributes
-        cxxtools::SerializationInfo& si_asset_ext_list = si_asset.addMember("ext");
-        si_asset_ext_list.setCategory(cxxtools::SerializationInfo::Category::Array);
-
-        std::string asset_tag;
-        r["asset_tag"].get(asset_tag);
-        if (!asset_tag.empty()) {
-            cxxtools::SerializationInfo& si_ext_asset_tag = si_asset_ext_list.addMember("");
-            si_ext_asset_tag.addMember("asset_tag") <<= asset_tag;
-            si_ext_asset_tag.addMember("read_only") <<= false;
+    // Print Ips
+    cxxtools::SerializationInfo& si_ips_list = si_asset.addMember("ips");
+    si_ips_list.setCategory(cxxtools::SerializationInfo::Category::Array);
+    for (const auto& k : ext_attrs) {
+        if (k.first.compare(0, t_ip.length(), t_ip) == 0) {
+            si_ips_list.addMember("") <<= k.second.first;
         }
+    }
 
-        std::string                   t_ip("ip.");
-        cxxtools::Regex               r_outlet_label("^outlet\\.[0-9][0-9]*\\.label$");
-        cxxtools::Regex               r_outlet_group("^outlet\\.[0-9][0-9]*\\.group$");
-        cxxtools::Regex               r_outlet_type("^outlet\\.[0-9][0-9]*\\.type$");
-        std::map<std::string, Outlet> outlets;
-
-        // Print extended attributes
-        for (const auto& k : ext_attrs) {
-            if (k.first != "name" && (k.first.compare(0, t_ip.length(), t_ip) != 0)) {
-                // filter location_type (already present)
-                if (k.first == "location_type")
-                    continue;
-
-                // We don't want info use in outlets
-                if (r_outlet_label.match(k.first)) {
-                    auto oNumber = getOutletNumber(k.first);
-                    auto it      = outlets.find(oNumber);
-                    if (it == outlets.cend()) {
-                        auto r1 = outlets.emplace(oNumber, Outlet());
-                        it     = r1.first;
-                    }
-                    it->second.label   = k.second.first;
-                    it->second.label_r = k.second.second;
-                    continue;
-                } else if (r_outlet_group.match(k.first)) {
-                    auto oNumber = getOutletNumber(k.first);
-                    auto it      = outlets.find(oNumber);
-                    if (it == outlets.cend()) {
-                        auto r1 = outlets.emplace(oNumber, Outlet());
-                        it     = r1.first;
-                    }
-                    it->second.group   = k.second.first;
-                    it->second.group_r = k.second.second;
-                    continue;
-                } else if (r_outlet_type.match(k.first)) {
-                    auto oNumber = getOutletNumber(k.first);
-                    auto it      = outlets.find(oNumber);
-                    if (it == outlets.cend()) {
-                        auto r1 = outlets.emplace(oNumber, Outlet());
-                        it     = r1.first;
-                    }
-                    it->second.type   = k.second.first;
-                    it->second.type_r = k.second.second;
-                    continue;
-                }
-                // print valid info
-                cxxtools::SerializationInfo& si_ext_obj = si_asset_ext_list.addMember("");
-                si_ext_obj.addMember(k.first) <<= k.second.first;
-                si_ext_obj.addMember("read_only") <<= k.second.second;
+    // Print outlets
+    if (!outlets.empty()) {
+        cxxtools::SerializationInfo& si_outlets = si_asset.addMember("outlets");
+        for (auto& oneOutlet : outlets) {
+            cxxtools::SerializationInfo& si_outlet_x = si_outlets.addMember(oneOutlet.first);
+            si_outlet_x.setCategory(cxxtools::SerializationInfo::Category::Array);
+
+            cxxtools::SerializationInfo& si_outlet_label = si_outlet_x.addMember("");
+            si_outlet_label.addMember("name") <<= "label";
+            si_outlet_label.addMember("value") <<= oneOutlet.second.label;
+            si_outlet_label.addMember("read_only") <<= oneOutlet.second.label_r;
+
+            if (!oneOutlet.second.group.empty()) {
+                cxxtools::SerializationInfo& si_outlet_group = si_outlet_x.addMember("");
+                si_outlet_group.addMember("name") <<= "group";
+                si_outlet_group.addMember("value") <<= oneOutlet.second.group;
+                si_outlet_group.addMember("read_only") <<= oneOutlet.second.group_r;
             }
-        }
 
-        // Print Ips
-        cxxtools::SerializationInfo& si_ips_list = si_asset.addMember("ips");
-        si_ips_list.setCategory(cxxtools::SerializationInfo::Category::Array);
-        for (const auto& k : ext_attrs) {
-            if (k.first.compare(0, t_ip.length(), t_ip) == 0) {
-                si_ips_list.addMember("") <<= k.second.first;
+            if (!oneOutlet.second.type.empty()) {
+                cxxtools::SerializationInfo& si_outlet_type = si_outlet_x.addMember("");
+                si_outlet_type.addMember("name") <<= "type";
+                si_outlet_type.addMember("value") <<= oneOutlet.second.type;
+                si_outlet_type.addMember("read_only") <<= oneOutlet.second.type_r;
             }
         }
+    }
 
-        // Print outlets
-        if (!outlets.empty()) {
-            cxxtools::SerializationInfo& si_outlets = si_asset.addMember("outlets");
-            for (auto& oneOutlet : outlets) {
-                cxxtools::SerializationInfo& si_outlet_x = si_outlets.addMember(oneOutlet.first);
-                si_outlet_x.setCategory(cxxtools::SerializationInfo::Category::Array);
-
-                cxxtools::SerializationInfo& si_outlet_label = si_outlet_x.addMember("");
-                si_outlet_label.addMember("name") <<= "label";
-                si_outlet_label.addMember("value") <<= oneOutlet.second.label;
-                si_outlet_label.addMember("read_only") <<= oneOutlet.second.label_r;
-
-                if (!oneOutlet.second.group.empty()) {
-                    cxxtools::SerializationInfo& si_outlet_group = si_outlet_x.addMember("");
-                    si_outlet_group.addMember("name") <<= "group";
-                    si_outlet_group.addMember("value") <<= oneOutlet.second.group;
-                    si_outlet_group.addMember("read_only") <<= oneOutlet.second.group_r;
-                }
+    cxxtools::JsonSerializer serializer(out);
+    serializer.serialize(si_asset).finish();
+}
 
-                if (!oneOutlet.second.type.empty()) {
-                    cxxtools::SerializationInfo& si_outlet_type = si_outlet_x.addMember("");
-                    si_outlet_type.addMember("name") <<= "type";
-                    si_outlet_type.addMember("value") <<= oneOutlet.second.type;
-                    si_outlet_type.addMember("read_only") <<= oneOutlet.second.type_r;
-                }
-            }
+void export_asset_json(std::ostream& out, std::set<std::string>* listElements)
+{
+    // 0.) tntdb connection
+    tntdb::Connection conn;
+    std::string       msg{"no connection to database"};
+    try {
+        conn = tntdb::connect(DBConn::url);
+    } catch (...) {
+        log_error("%s", msg.c_str());
+        LOG_END;
+        throw std::runtime_error(msg.c_str());
+    }
+    tntdb::Transaction transaction{conn, true};
+
+    // only listed assets are exported, filter is applied by the queries
+    std::vector<a_elmnt_id_t> ids;
+    if (listElements != NULL) {
+        ids = s_select_ids(conn, *listElements);
+    }
+
+    out << '[';
+    bool first = true;
+    // assets are read and printed in chunks, so memory does not grow with inventory
+    for (const auto& in : shared::sql_in_lists(ids)) {
+        // 2.1      extended attributes of the chunk
+        std::unordered_map<a_elmnt_id_t, std::map<std::string, std::pair<std::string, bool>>> ext_attrs;
+        std::set<std::string>                                                                 logical_assets;
+        for (const auto& r : conn.prepare(" SELECT v.id_asset_element, v.keytag, v.value, v.read_only"
+                                          " FROM v_bios_asset_ext_attributes v"
+                                          " WHERE v.id_asset_element IN (" + in + ")")
+                                 .select()) {
+            std::string keytag, value;
+            bool        read_only = false;
+            r[1].get(keytag);
+            r[2].get(value);
+            r[3].get(read_only);
+            if (keytag == "logical_asset")
+                logical_assets.insert(value);
+            ext_attrs[r.getUnsigned32(0)].emplace(keytag, std::make_pair(value, read_only));
+        }
+        auto extnames = s_select_extnames(conn, logical_assets);
+
+        // 2.3 links leading to the chunk, in the order DBAssets::select_v_web_asset_power_link_src_byId gives
+        std::unordered_map<a_elmnt_id_t, std::vector<JsonPowerLink>> power_links;
+        for (const auto& r : conn.prepare(" SELECT v.id_asset_element_dest, v.src_name, v.src_out, v.dest_in, e.value"
+                                          " FROM v_web_asset_link v"
+                                          " LEFT JOIN t_bios_asset_ext_attributes e"
+                                          "   ON e.id_asset_element = v.id_asset_element_src AND e.keytag = 'name'"
+                                          " WHERE v.id_asset_link_type = :linktype AND"
+                                          "   v.id_asset_element_dest IN (" + in + ")"
+                                          " ORDER BY v.id_asset_element_dest, v.id_link")
+                                 .set("linktype", INPUT_POWER_CHAIN)
+                                 .select()) {
+            // source without external name, DBAssets::name_to_extname fails the same
+            if (r[4].isNull())
+                throw std::runtime_error(msg.c_str());
+            JsonPowerLink link;
+            r[1].get(link.src_name);
+            r[2].get(link.src_out);
+            r[3].get(link.dest_in);
+            r[4].get(link.src_extname);
+            power_links[r.getUnsigned32(0)].push_back(std::move(link));
         }
-    };
 
-    int rv = DBAssets::select_asset_element_all(conn, process_v_web_asset_element_row_json);
-    if (rv != 0)
-        throw std::runtime_error(msg.c_str());
+        // 2. FOR EACH ROW of the chunk, with names of the asset and its parent
+        static const std::vector<JsonPowerLink> NO_LINKS;
+        for (const auto& r : conn.prepare(" SELECT"
+                                          "   v.id, v.name, v.id_parent, v.status, v.priority, v.type_name,"
+                                          "   v.subtype_name, v.asset_tag, e.value AS ext_name,"
+                                          "   p.name AS parent_name, p.type_name AS parent_type_name,"
+                                          "   pe.value AS parent_ext_name"
+                                          " FROM v_web_element v"
+                                          " LEFT JOIN t_bios_asset_ext_attributes e"
+                                          "   ON e.id_asset_element = v.id AND e.keytag = 'name'"
+                                          " LEFT JOIN v_web_element p ON p.id = v.id_parent"
+                                          " LEFT JOIN t_bios_asset_ext_attributes pe"
+                                          "   ON pe.id_asset_element = v.id_parent AND pe.keytag = 'name'"
+                                          " WHERE v.id IN (" + in + ")"
+                                          " ORDER BY v.id")
+                                 .select()) {
+            a_elmnt_id_t id_num = r.getUnsigned32("id");
+            auto         links  = power_links.find(id_num);
+
+            if (!first)
+                out << ',';
+            first = false;
+            s_print_json_asset(out, r, ext_attrs[id_num], links == power_links.end() ? NO_LINKS : links->second,
+                extnames, msg);
+        }
+        out.flush();
+    }
+    out << ']';
 
-    serializer.serialize(si).finish();
     transaction.commit();
 }
 
@@ -0,0 +1,110 @@
+/*
+ *
+ * Copyright (C) 2015 - 2020 Eaton
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "db/inout/importactivation.h"
+#include "shared/utils_json.h"
+#include <fty_asset_activator.h>
+#include <fty_common.h>
+#include <fty_common_macros.h>
+#include <fty_common_mlm_sync_client.h>
+#include <map>
+
+#define AGENT_ASSET_ACTIVATOR "etn-licensing-credits"
+
+namespace persist {
+
+ImportActivation::ImportActivation()
+    : _client{}
+    , _activator{}
+    , _pending{}
+    , _ids{}
+{
+}
+
+// out of line, client and activator are incomplete in the header
+ImportActivation::~ImportActivation() = default;
+
+fty::AssetActivator& ImportActivation::activator()
+{
+    if (!_activator) {
+        _client.reset(new mlm::MlmSyncClient(AGENT_FTY_ASSET, AGENT_ASSET_ACTIVATOR));
+        _activator.reset(new fty::AssetActivator(*_client));
+    }
+    return *_activator;
+}
+
+void ImportActivation::add(a_elmnt_id_t id, const std::string& name)
+{
+    if (_ids.insert(id).second) {
+        _pending.push_back(Pending{id, name});
+    }
+}
+
+void ImportActivation::deactivate(tntdb::Connection& conn, a_elmnt_id_t id)
+{
+    activator().deactivate(getJsonAssets(conn, NULL, {id})[id]);
+}
+
+void ImportActivation::flush(tntdb::Connection& conn, const done_fn& done)
+{
+    if (_pending.empty()) {
+        return;
+    }
+    log_debug("activating %zu devices", _pending.size());
+
+    // JSON of all devices is read at once before the first request
+    std::vector<std::string>       warnings(_pending.size());
+    std::map<int64_t, std::string> assets_json;
+    try {
+        std::vector<int64_t> ids;
+        ids.reserve(_pending.size());
+        for (const auto& pending : _pending) {
+            ids.push_back(pending.id);
+        }
+        assets_json = getJsonAssets(conn, NULL, ids);
+    } catch (const std::exception& e) {
+        for (auto& warning : warnings) {
+            warning = e.what();
+        }
+    }
+
+    for (size_t i = 0; i != _pending.size(); ++i) {
+        if (warnings[i].empty()) {
+            try {
+                activator().activate(assets_json[_pending[i].id]);
+            } catch (const std::exception& e) {
+                warnings[i] = e.what();
+            }
+        }
+        if (!warnings[i].empty()) {
+            warnings[i] = TRANSLATE_ME("Element '%s' is updated but a licensing error occured: %s",
+                _pending[i].name.c_str(), warnings[i].c_str());
+        }
+    }
+
+    std::vector<Pending> pending;
+    pending.swap(_pending);
+    _ids.clear();
+    for (size_t i = 0; i != pending.size(); ++i) {
+        done(pending[i].id, warnings[i]);
+    }
+}
+
+} // namespace persist
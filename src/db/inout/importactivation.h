@@ -0,0 +1,97 @@
+/*
+ *
+ * Copyright (C) 2015 - 2020 Eaton
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/// \file   importactivation.h
+/// \brief  Deferred activation of devices during csv import
+///
+/// Devices requested as active are written as nonactive and activated once the import is done. All of them go over
+/// one client, their JSON is built at once on one connection and each device still gets its own licensing result.
+#pragma once
+
+#include "db/dbhelpers.h"
+#include <fty_common_db_asset.h>
+#include <functional>
+#include <memory>
+#include <set>
+#include <string>
+#include <tntdb/connection.h>
+#include <vector>
+
+namespace mlm {
+class MlmSyncClient;
+}
+namespace fty {
+class AssetActivator;
+}
+
+namespace persist {
+
+/// @class ImportActivation
+class ImportActivation
+{
+public:
+    /// result of activation of the device, warning is empty on success
+    using done_fn = std::function<void(a_elmnt_id_t, const std::string&)>;
+
+    ImportActivation();
+    ~ImportActivation();
+
+    /// Adds written device to be activated by flush
+    void add(a_elmnt_id_t id, const std::string& name);
+
+    /// return if the device waits for activation
+    bool contains(a_elmnt_id_t id) const
+    {
+        return _ids.count(id) != 0;
+    }
+
+    bool empty() const
+    {
+        return _pending.empty();
+    }
+
+    /// Deactivates the device at once, before it is updated
+    ///
+    /// @param[in] conn - connection its JSON is read over
+    /// @throws std::exception on licensing error
+    void deactivate(tntdb::Connection& conn, a_elmnt_id_t id);
+
+    /// Activates all collected devices and reports each of them, nothing waits afterwards
+    ///
+    /// @param[in] conn - connection JSON of all devices is read over
+    void flush(tntdb::Connection& conn, const done_fn& done);
+
+private:
+    struct Pending
+    {
+        a_elmnt_id_t id;
+        std::string  name;
+    };
+
+    /// return activator, client is connected by the first use
+    fty::AssetActivator& activator();
+
+    std::unique_ptr<mlm::MlmSyncClient>  _client;
+    std::unique_ptr<fty::AssetActivator> _activator;
+    std::vector<Pending>                 _pending;
+    std::set<a_elmnt_id_t>               _ids; // ids in _pending
+};
+
+} // namespace persist
@@ -0,0 +1,268 @@
+/*
+ *
+ * Copyright (C) 2015 - 2020 Eaton
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "db/inout/importbatch.h"
+#include "db/inout/importplan.h"
+#include "persist/assetnames.h"
+#include "persist/assettree.h"
+#include "persist/rackcapacity.h"
+#include "shared/sql_in.h"
+#include "shared/utilspp.h"
+#include <algorithm>
+#include <fty/string-utils.h>
+#include <fty_common.h>
+#include <fty_common_db.h>
+#include <fty_common_macros.h>
+#include <fty_common_rest.h>
+#include <locale.h>
+#include <tntdb/result.h>
+#include <tntdb/row.h>
+#include <tntdb/statement.h>
+#include <tntdb/transaction.h>
+
+namespace persist {
+
+// MySQL limits number of placeholders in one statement
+static const size_t ROWS_PER_STATEMENT = 500;
+
+// runs INSERT INTO table (columns) VALUES (...), (...) for count rows in statements of ROWS_PER_STATEMENT rows,
+// bind(st, i, suffix) sets values of i-th row, placeholders are named as columns with the suffix
+template <typename Bind>
+static void s_insert_rows(
+    tntdb::Connection& conn, const char* table, const std::vector<std::string>& columns, size_t count, Bind bind)
+{
+    for (size_t first = 0; first < count; first += ROWS_PER_STATEMENT) {
+        size_t n = std::min(ROWS_PER_STATEMENT, count - first);
+
+        std::string sql = std::string{" INSERT INTO "} + table + " (" + fty::implode(columns, ", ") + ") VALUES";
+        for (size_t i = 0; i != n; i++) {
+            sql += i == 0 ? " (" : ", (";
+            for (size_t c = 0; c != columns.size(); c++) {
+                sql += (c == 0 ? ":" : ", :") + columns[c] + std::to_string(i);
+            }
+            sql += ")";
+        }
+
+        tntdb::Statement st = conn.prepare(sql);
+        for (size_t i = 0; i != n; i++) {
+            bind(st, first + i, std::to_string(i));
+        }
+        st.execute();
+    }
+}
+
+void ImportBatch::add(ImportRow&& row)
+{
+    std::string iname;
+    std::string key = ImportPlan::key(row.ename);
+    if (_names.extname_to_asset_name(row.ename, iname) == 0 || _new_names.count(key) != 0) {
+        throw BiosError(8, TRANSLATE_ME("Element '%s' cannot be processed because of conflict. Most likely duplicate entry.",
+                               row.ename.c_str()));
+    }
+    if (row.element.type_id != asset_type::DEVICE && row.write_status == "nonactive") {
+        throw BiosError(
+            8, TRANSLATE_ME("Element '%s' cannot be inactivated. Change status to 'active'.", row.ename.c_str()));
+    }
+
+    _pending.insert(row.row_i);
+    _new_names.insert(key);
+    _rows.push_back(std::move(row));
+}
+
+void ImportBatch::flush(tntdb::Connection& conn, const ok_fn& ok, const fail_fn& fail)
+{
+    if (_rows.empty()) {
+        return;
+    }
+    log_debug("writing batch of %zu new assets", _rows.size());
+    write_or_split(conn, _rows.begin(), _rows.end(), ok, fail);
+    _rows.clear();
+    _pending.clear();
+    _new_names.clear();
+}
+
+void ImportBatch::write_or_split(
+    tntdb::Connection& conn, iterator begin, iterator end, const ok_fn& ok, const fail_fn& fail)
+{
+    try {
+        write(conn, begin, end);
+    } catch (const std::exception& e) {
+        if (end - begin == 1) {
+            log_error("row %zu not imported: %s", begin->row_i, e.what());
+            fail(begin->row_i, e.what());
+            return;
+        }
+        // nothing was written, find the failing rows
+        log_warning("batch of %zu rows failed, splitting it: %s", size_t(end - begin), e.what());
+        iterator middle = begin + (end - begin) / 2;
+        write_or_split(conn, begin, middle, ok, fail);
+        write_or_split(conn, middle, end, ok, fail);
+        return;
+    }
+
+    std::vector<db_a_elmnt_name_t> written;
+    std::vector<uint32_t>          ids;
+    written.reserve(size_t(end - begin));
+    for (auto it = begin; it != end; ++it) {
+        written.push_back({it->element.id, it->element.name, it->ename});
+        ids.push_back(it->element.id);
+        if (_names.loaded()) {
+            _names.update(it->element.id, it->element.name, it->ename);
+        }
+        // new asset takes space and outlets in its rack
+        RackCapacity::instance().invalidate(it->element.id);
+    }
+    AssetNames::update(written);
+    AssetTree::instance().reload(conn, ids);
+
+    // caches know the batch before anybody is told, the callback may abort the import
+    for (auto it = begin; it != end; ++it) {
+        ok(*it);
+    }
+}
+
+void ImportBatch::write(tntdb::Connection& conn, iterator begin, iterator end)
+{
+    tntdb::Transaction trans(conn);
+    setlocale(LC_ALL, ""); // move this to main?
+
+    // elements one by one, their internal names are derived from the id
+    for (auto it = begin; it != end; ++it) {
+        db_a_elmnt_t& el     = it->element;
+        const bool    device = el.type_id == asset_type::DEVICE;
+        std::string   iname =
+            utils::strip(device ? persist::subtypeid_to_subtype(el.subtype_id) : persist::typeid_to_type(el.type_id));
+        auto reply = DBAssetsInsert::insert_into_asset_element(conn, iname.c_str(), el.type_id, el.parent_id,
+            it->write_status.c_str(), el.priority, device ? el.subtype_id : 0, el.asset_tag.c_str(), false);
+        if (reply.status == 0) {
+            throw BiosError(reply.rowid, JSONIFY(reply.msg.c_str()));
+        }
+        el.id = uint32_t(reply.rowid);
+        // links don't have 'dest' defined - it was not known until now; we have to fix it
+        for (auto& one_link : it->links) {
+            one_link.dest = el.id;
+        }
+    }
+
+    struct ext_t
+    {
+        a_elmnt_id_t       id;
+        const std::string* key;
+        const std::string* value;
+        bool               read_only;
+    };
+    std::vector<ext_t>                                 ext;
+    std::vector<std::pair<a_elmnt_id_t, a_elmnt_id_t>> groups; // group, element
+    std::vector<const link_t*>                         links;
+    for (auto it = begin; it != end; ++it) {
+        for (const auto& kv : it->element.ext) {
+            ext.push_back(ext_t{it->element.id, &kv.first, &kv.second, false});
+        }
+        for (const auto& kv : it->ext_ro) {
+            ext.push_back(ext_t{it->element.id, &kv.first, &kv.second, true});
+        }
+        for (auto group_id : it->groups) {
+            groups.emplace_back(group_id, it->element.id);
+        }
+        for (const auto& one_link : it->links) {
+            links.push_back(&one_link);
+        }
+    }
+
+    s_insert_rows(conn, "t_bios_asset_ext_attributes", {"keytag", "value", "id_asset_element", "read_only"},
+        ext.size(), [&ext](tntdb::Statement& st, size_t i, const std::string& n) {
+            st.set("keytag" + n, *ext[i].key)
+                .set("value" + n, *ext[i].value)
+                .set("id_asset_element" + n, ext[i].id)
+                .set("read_only" + n, ext[i].read_only);
+        });
+
+    s_insert_rows(conn, "t_bios_asset_group_relation", {"id_asset_group", "id_asset_element"}, groups.size(),
+        [&groups](tntdb::Statement& st, size_t i, const std::string& n) {
+            st.set("id_asset_group" + n, groups[i].first).set("id_asset_element" + n, groups[i].second);
+        });
+
+    s_insert_rows(conn, "t_bios_asset_link",
+        {"id_asset_device_src", "src_out", "id_asset_device_dest", "dest_in", "id_asset_link_type"}, links.size(),
+        [&links](tntdb::Statement& st, size_t i, const std::string& n) {
+            const link_t* one_link = links[i];
+            st.set("id_asset_device_src" + n, one_link->src)
+                .set("id_asset_device_dest" + n, one_link->dest)
+                .set("id_asset_link_type" + n, one_link->type);
+            if (one_link->src_out != NULL && one_link->src_out[0] != '\0') {
+                st.set("src_out" + n, one_link->src_out);
+            } else {
+                st.setNull("src_out" + n);
+            }
+            if (one_link->dest_in != NULL && one_link->dest_in[0] != '\0') {
+                st.set("dest_in" + n, one_link->dest_in);
+            } else {
+                st.setNull("dest_in" + n);
+            }
+        });
+
+    // monitor part, same as insert_device and insert_dc_room_row_rack_group
+    // BIOS-1962: we do not use this classification. So ignore it.
+    auto not_classified = DBAssets::select_monitor_device_type_id(conn, "not_classified");
+    if (not_classified.status == 0 && not_classified.errsubtype != DB_ERROR_NOTFOUND) {
+        throw BiosError(not_classified.rowid, JSONIFY(not_classified.msg.c_str()));
+    }
+    for (auto it = begin; it != end; ++it) {
+        uint16_t monitor_type = 0;
+        if (it->element.type_id == asset_type::DATACENTER || it->element.type_id == asset_type::RACK) {
+            monitor_type = 1;
+        } else if (it->element.type_id == asset_type::DEVICE && not_classified.status == 1) {
+            monitor_type = uint16_t(not_classified.item);
+        } else {
+            continue;
+        }
+        auto reply_monitor = DBAssetsInsert::insert_into_monitor_device(conn, monitor_type, it->ename.c_str());
+        if (reply_monitor.status == 0) {
+            throw BiosError(reply_monitor.rowid, JSONIFY(reply_monitor.msg.c_str()));
+        }
+        auto reply_relation = DBAssetsInsert::insert_into_monitor_asset_relation(
+            conn, uint16_t(reply_monitor.rowid), it->element.id);
+        if (reply_relation.status == 0) {
+            throw BiosError(reply_relation.rowid, JSONIFY(reply_relation.msg.c_str()));
+        }
+    }
+
+    // internal names assigned by DB
+    std::vector<a_elmnt_id_t> ids;
+    for (auto it = begin; it != end; ++it) {
+        ids.push_back(it->element.id);
+    }
+    std::map<a_elmnt_id_t, std::string> names;
+    for (const auto& in : shared::sql_in_lists(ids)) {
+        for (const auto& row :
+            conn.prepare(" SELECT id_asset_element, name FROM t_bios_asset_element"
+                         " WHERE id_asset_element IN (" + in + ")")
+                .select()) {
+            names[row.getUnsigned32("id_asset_element")] = row.getString("name");
+        }
+    }
+    for (auto it = begin; it != end; ++it) {
+        it->element.name = names[it->element.id];
+    }
+
+    trans.commit();
+}
+
+} // namespace persist
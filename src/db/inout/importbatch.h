@@ -0,0 +1,121 @@
+/*
+ *
+ * Copyright (C) 2015 - 2020 Eaton
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/// \file   importbatch.h
+/// \brief  Batched insert of new assets during csv import
+///
+/// Validated rows creating new assets are collected and written together in one transaction: elements one by one
+/// (DB assigns their names), ext attributes, group relations and power links with multi row INSERT statements.
+/// When the batch fails, it is rolled back and split in halves until the failing rows are found, so every row
+/// still gets its own result.
+#pragma once
+
+#include "db/dbhelpers.h"
+#include "db/inout/importnames.h"
+#include <fty_common_db_asset.h>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <tntdb/connect.h>
+#include <unordered_set>
+#include <vector>
+
+namespace persist {
+
+/// New asset waiting for the write
+struct ImportRow
+{
+    size_t                             row_i;        // row in csv
+    std::string                        ename;        // external name
+    db_a_elmnt_t                       element;      // id and name are set once written
+    std::map<std::string, std::string> ext_ro;       // read only ext attributes, element.ext are the others
+    std::set<a_elmnt_id_t>             groups;       // groups the asset belongs to
+    std::vector<link_t>                links;        // power sources, dest is set once written
+    std::string                        write_status; // status written to DB, device is activated after write
+    bool                               activate;     // activate the device once written
+};
+
+/// @class ImportBatch
+class ImportBatch
+{
+public:
+    /// row was written
+    using ok_fn = std::function<void(ImportRow&)>;
+    /// row was not written, with the reason
+    using fail_fn = std::function<void(size_t, const std::string&)>;
+
+    /// Creates empty batch
+    ///
+    /// @param[in] names    - names of assets, new assets are registered here once written
+    /// @param[in] max_rows - number of rows written in one transaction
+    ImportBatch(ImportNames& names, size_t max_rows = 256)
+        : _names{names}
+        , _max_rows{max_rows}
+        , _rows{}
+        , _pending{}
+        , _new_names{} {};
+
+    /// Adds validated row to the batch
+    ///
+    /// @throws BiosError if the asset can't be inserted (duplicate name, forbidden status)
+    void add(ImportRow&& row);
+
+    /// return if the row waits in the batch
+    bool contains(size_t row_i) const
+    {
+        return _pending.count(row_i) != 0;
+    }
+
+    /// return if asset of the external name, normalized by ImportPlan::key, waits in the batch
+    bool contains_key(const std::string& key) const
+    {
+        return _new_names.count(key) != 0;
+    }
+
+    bool empty() const
+    {
+        return _rows.empty();
+    }
+
+    bool full() const
+    {
+        return _rows.size() >= _max_rows;
+    }
+
+    /// Writes all rows and reports each of them by one of callbacks, batch is empty afterwards
+    void flush(tntdb::Connection& conn, const ok_fn& ok, const fail_fn& fail);
+
+private:
+    using iterator = std::vector<ImportRow>::iterator;
+
+    /// write rows in one transaction, throws on failure and nothing is written
+    void write(tntdb::Connection& conn, iterator begin, iterator end);
+    /// write rows, on failure split them and try again
+    void write_or_split(tntdb::Connection& conn, iterator begin, iterator end, const ok_fn& ok, const fail_fn& fail);
+
+    ImportNames&                    _names;
+    size_t                          _max_rows;
+    std::vector<ImportRow>          _rows;
+    std::unordered_set<size_t>      _pending;   // rows in batch
+    std::unordered_set<std::string> _new_names; // normalized external names in batch
+};
+
+} // namespace persist
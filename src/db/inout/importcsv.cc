@@ -28,39 +28,62 @@
 #include "db/asset_general.h"
 #include "db/dbhelpers.h"
 #include "db/inout.h"
+#include "db/inout/importactivation.h"
+#include "db/inout/importbatch.h"
+#include "db/inout/importnames.h"
+#include "db/inout/importplan.h"
+#include "db/inout/licensinglimitations.h"
 #include "persist/assetcrud.h"
+#include "persist/assetdictionary.h"
 #include "shared/utils.h"
 #include "shared/utils_json.h"
 #include "shared/utilspp.h"
 #include <algorithm>
+#include <cinttypes>
 #include <cstddef>
 #include <ctype.h>
+#include <exception>
 #include <fty/string-utils.h>
-#include <fty_asset_activator.h>
 #include <fty_common_db.h>
 #include <fty_common_db_dbpath.h>
 #include <fty_common_mlm_pool.h>
-#include <fty_common_mlm_sync_client.h>
 #include <fty_common_rest.h>
 #include <fty_proto.h>
 #include <limits>
 #include <regex>
 #include <string>
+#include <thread>
 #include <tntdb/connect.h>
 #include <unordered_set>
 
-
-#define AGENT_ASSET_ACTIVATOR "etn-licensing-credits"
-
 using namespace shared;
 
 namespace persist {
 
-typedef struct _LIMITATIONS_STRUCT
+/*
+ * \brief Columns read by process_row on every row, resolved once per import
+ */
+struct ImportColumns
 {
-    int max_active_power_devices;
-    int global_configurability;
-} LIMITATIONS_STRUCT;
+    explicit ImportColumns(const CsvMap& cm)
+        : id{cm.column("id")}
+        , name{cm.column("name")}
+        , type{cm.column("type")}
+        , sub_type{cm.column("sub_type")}
+        , status{cm.column("status")}
+        , asset_tag{cm.column("asset_tag")}
+        , priority{cm.column("priority")}
+    {
+    }
+
+    ColumnHandle id;
+    ColumnHandle name;
+    ColumnHandle type;
+    ColumnHandle sub_type;
+    ColumnHandle status;
+    ColumnHandle asset_tag;
+    ColumnHandle priority;
+};
 
 int get_priority(const std::string& s)
 {
@@ -75,20 +98,6 @@ int get_priority(const std::string& s)
     return 5;
 }
 
-static std::map<std::string, int> read_element_types(tntdb::Connection& conn)
-{
-    auto res = get_dictionary_element_type(conn);
-    // in case of any error, it would be empty
-    return res.item;
-}
-
-static std::map<std::string, int> read_device_types(tntdb::Connection& conn)
-{
-    auto res = get_dictionary_device_type(conn);
-    // in case of any error, it would be empty
-    return res.item;
-}
-
 static bool check_u_size(std::string& s)
 {
     static std::regex regex("^[0-9]{1,2}[uU]?$");
@@ -139,6 +148,149 @@ static double sanitize_value_double(const std::string& key, const std::string& v
     }
 }
 
+/*
+ * \brief Checks of single values, which need no DB
+ *
+ * Used by process_row and by validate_asset_csv, which runs them on all rows before anything is written.
+ */
+static const std::set<std::string> STATUSES = {"active", "nonactive", "spare", "retired"};
+
+static void s_check_name(const std::string& ename)
+{
+    if (ename.empty()) {
+        std::string received = TRANSLATE_ME("empty value");
+        std::string expected = TRANSLATE_ME("unique, non empty value");
+        bios_throw("request-param-bad", "name", received.c_str(), expected.c_str());
+    }
+    if (ename.length() > 50) {
+        std::string received = TRANSLATE_ME("too long string");
+        std::string expected = TRANSLATE_ME("unique string from 1 to 50 characters");
+        bios_throw("request-param-bad", "name", received.c_str(), expected.c_str());
+    }
+}
+
+static int s_check_type(const std::string& type, const std::map<std::string, int>& TYPES)
+{
+    auto it = TYPES.find(type);
+    if (it == TYPES.end()) {
+        std::string received = type.empty() ? TRANSLATE_ME("empty value") : JSONIFY(type.c_str());
+        std::string expected = JSONIFY(utils::join_keys_map(TYPES, ", ").c_str());
+        bios_throw("request-param-bad", "type", received.c_str(), expected.c_str());
+    }
+    return it->second;
+}
+
+static void s_check_status(const std::string& status)
+{
+    if (STATUSES.find(status) == STATUSES.end()) {
+        std::string received = status.empty() ? TRANSLATE_ME("empty value") : JSONIFY(status.c_str());
+        std::string expected = JSONIFY(fty::implode(STATUSES, ", ").c_str());
+        bios_throw("request-param-bad", "status", received.c_str(), expected.c_str());
+    }
+}
+
+static void s_check_asset_tag(const std::string& asset_tag)
+{
+    if (asset_tag.length() > 50) {
+        std::string received = TRANSLATE_ME("too long string");
+        std::string expected = TRANSLATE_ME("unique string from 1 to 50 characters");
+        bios_throw("request-param-bad", "asset_tag", received.c_str(), expected.c_str());
+    }
+}
+
+// returns id of subtype, aliases of rack controller and patch panel are accepted
+static int s_check_subtype(
+    const std::string& type, const std::string& subtype, const std::map<std::string, int>& SUBTYPES)
+{
+    // Business requirement: be able to write 'rack controller', 'RC', 'rc' as subtype == 'rack controller'
+    static const std::map<std::string, std::string> ALIASES = {{"rackcontroller", "rack controller"},
+        {"rackcontroler", "rack controller"}, {"rc", "rack controller"}, {"RC", "rack controller"},
+        {"RC3", "rack controller"}, {"patchpanel", "patch panel"}};
+
+    auto it = SUBTYPES.find(subtype);
+    if (it == SUBTYPES.end()) {
+        auto alias = ALIASES.find(subtype);
+        if (alias != ALIASES.end()) {
+            it = SUBTYPES.find(alias->second);
+        }
+    }
+
+    if ((type == "device") && (it == SUBTYPES.end())) {
+        std::string received = subtype.empty() ? TRANSLATE_ME("empty value") : JSONIFY(subtype.c_str());
+        std::string expected = JSONIFY(utils::join_keys_map(SUBTYPES, ", ").c_str());
+        bios_throw("request-param-bad", "subtype", received.c_str(), expected.c_str());
+    }
+
+    if ((subtype.empty()) && (type == "group")) {
+        std::string expected = TRANSLATE_ME("subtype (for type group)");
+        bios_throw("request-param-required", expected.c_str());
+    }
+
+    return it == SUBTYPES.end() ? 0 : it->second;
+}
+
+// value of u_size or location_u_pos
+static void s_check_u_value(const std::string& key, const std::string& value)
+{
+    unsigned long ul = 0;
+    try {
+        std::size_t pos = 0;
+        ul              = std::stoul(value, &pos);
+        if (pos != value.length()) {
+            log_info("Extattribute: %s='%s' is not unsigned integer", key.c_str(), value.c_str());
+            std::string expected = TRANSLATE_ME("value must be an unsigned integer");
+            bios_throw("request-param-bad", key.c_str(), ("'" + value + "'").c_str(), expected.c_str());
+        }
+    } catch (const std::exception& e) {
+        log_info("Extattribute: %s='%s' is not unsigned integer", key.c_str(), value.c_str());
+        std::string expected = TRANSLATE_ME("value must be an unsigned integer");
+        bios_throw("request-param-bad", key.c_str(), ("'" + value + "'").c_str(), expected.c_str());
+    }
+    if (ul == 0 || ul > 52) {
+        std::string expected = TRANSLATE_ME("value must be between <1, 52>.");
+        bios_throw("request-param-bad", key.c_str(), ("'" + value + "'").c_str(), expected.c_str());
+    }
+}
+
+// checks the ext attribute, dates are converted to ISO format
+static void s_sanitize_ext_value(const std::string& key, std::string& value, const std::string& ename)
+{
+    if (value.empty()) {
+        return;
+    }
+
+    // BIOS-1564: sanitize the date for warranty_end
+    if (is_date(key)) {
+        char* date = sanitize_date(value.c_str());
+        if (!date) {
+            log_info("Cannot sanitize %s '%s' for device '%s'", key.c_str(), value.c_str(), ename.c_str());
+            std::string expected = TRANSLATE_ME("ISO date");
+            bios_throw("request-param-bad", key.c_str(), value.c_str(), expected.c_str());
+        }
+        value = date;
+        zstr_free(&date);
+    }
+
+    // BIOS-2302: Check some attributes for sensors
+    // BIOS-2784: Check max_current, max_power
+    if (key == "calibration_offset_t" || key == "calibration_offset_h") {
+        // we want exceptions to propagate to upper layer
+        sanitize_value_double(key, value);
+    } else if (key == "max_current" || key == "max_power") {
+        // we want exceptions to propagate to upper layer
+        double d_value = sanitize_value_double(key, value);
+        if (d_value < 0) {
+            log_info("Extattribute: %s='%s' is neither positive not zero", key.c_str(), value.c_str());
+            std::string expected = TRANSLATE_ME("value must be a not negative number");
+            bios_throw("request-param-bad", key.c_str(), ("'" + value + "'").c_str(), expected.c_str());
+        }
+    }
+    // BIOS-2781, BIOS-2799
+    if (key == "location_u_pos" || key == "u_size") {
+        s_check_u_value(key, value);
+    }
+}
+
 
 /*
  * \brief Case insensitive comparison
@@ -531,12 +683,13 @@ int promote_rc0(MlmClient* client, const CsvMap& cm, touch_cb_t touch_fn)
 /*
  * \brief Replace user defined names with internal names
  */
-std::map<std::string, std::string> sanitize_row_ext_names(const CsvMap& cm, size_t row_i, bool sanitize)
+std::map<std::string, std::string> sanitize_row_ext_names(
+    const CsvMap& cm, size_t row_i, bool sanitize, const ImportNames& names)
 {
     std::map<std::string, std::string> result;
     // make copy of this one line
-    for (auto title : cm.getTitles()) {
-        result[title] = cm.get(row_i, title);
+    for (size_t col_i = 0; col_i != cm.cols(); ++col_i) {
+        result.emplace(cm.titles()[col_i], cm.get(row_i, cm.column_at(col_i)));
     }
     if (sanitize) {
         // sanitize ext names to t_bios_asset_element.name
@@ -551,7 +704,7 @@ std::map<std::string, std::string> sanitize_row_ext_names(const CsvMap& cm, size
                         break;
 
                     std::string name;
-                    int         rv = DBAssets::extname_to_asset_name(it->second, name);
+                    int         rv = names.extname_to_asset_name(it->second, name);
                     if (rv != 0) {
                         name = it->second;
                     }
@@ -563,7 +716,7 @@ std::map<std::string, std::string> sanitize_row_ext_names(const CsvMap& cm, size
                 auto it = result.find(item);
                 if (it != result.end()) {
                     std::string name;
-                    int         rv = DBAssets::extname_to_asset_name(it->second, name);
+                    int         rv = names.extname_to_asset_name(it->second, name);
                     if (rv != 0) {
                         name = it->second;
                     }
@@ -577,97 +730,46 @@ std::map<std::string, std::string> sanitize_row_ext_names(const CsvMap& cm, size
 }
 
 
-/*
- * \brief Request licensing limitation
- * TODO if there will be more limitations, fix return value to struct instead of int
- *
- */
-
-void get_licensing_limitation(LIMITATIONS_STRUCT& limitations)
-{
-    // default values
-    limitations.max_active_power_devices = -1;
-    limitations.global_configurability   = 0;
-    // query values
-    auto    client_ptr = mlm_pool.get();
-    zmsg_t* request    = zmsg_new();
-    zmsg_addstr(request, "LIMITATION_QUERY");
-    zuuid_t*    zuuid     = zuuid_new();
-    const char* zuuid_str = zuuid_str_canonical(zuuid);
-    zmsg_addstr(request, zuuid_str);
-    zmsg_addstr(request, "*");
-    zmsg_addstr(request, "*");
-    int rv = client_ptr->sendto("etn-licensing", "LIMITATION_QUERY", 1000, &request);
-    if (rv == -1) {
-        zuuid_destroy(&zuuid);
-        zmsg_destroy(&request);
-        log_fatal("Cannot send message to etn-licensing");
-        std::string err = TRANSLATE_ME("mlm_client_sendto failed.");
-        bios_throw("internal-error", err.c_str());
-    }
-
-    zmsg_t* response = client_ptr->recv(zuuid_str, 30);
-    zuuid_destroy(&zuuid);
-    if (!response) {
-        log_fatal("client->recv (timeout = '30') returned NULL for LIMITATION_QUERY");
-        std::string err = TRANSLATE_ME("client->recv () returned NULL");
-        bios_throw("internal-error", err.c_str());
-    }
-    char* reply  = zmsg_popstr(response);
-    char* status = zmsg_popstr(response);
-    if (streq(status, "OK") && streq(reply, "REPLY")) {
-        zmsg_t* submsg = zmsg_popmsg(response);
-        while (submsg) {
-            fty_proto_t* submetric = fty_proto_decode(&submsg);
-            assert(fty_proto_id(submetric) == FTY_PROTO_METRIC);
-            if (streq(fty_proto_name(submetric), "rackcontroller-0") &&
-                streq(fty_proto_type(submetric), "power_nodes.max_active")) {
-                limitations.max_active_power_devices = atoi(fty_proto_value(submetric));
-                log_debug("limitations.max_active_power_device set to %i", limitations.max_active_power_devices);
-            } else if (
-                streq(fty_proto_name(submetric), "rackcontroller-0") &&
-                streq(fty_proto_type(submetric), "configurability.global")) {
-                limitations.global_configurability = atoi(fty_proto_value(submetric));
-                log_debug("limitations.global_configurability set to %i", limitations.global_configurability);
-            }
-            fty_proto_destroy(&submetric);
-            submsg = zmsg_popmsg(response);
-        }
-    }
-    zstr_free(&reply);
-    zstr_free(&status);
-    zmsg_destroy(&response);
-}
-
-
 /*
  * \brief Processes a single row from csv file
  *
  * \param[in] conn     - a connection to DB
  * \param[in] cm       - already parsed csv file
+ * \param[in] columns  - columns of cm resolved by ImportColumns
  * \param[in] row_i    - number of row to process
  * \param[in] TYPES    - list of available types
  * \param[in] SUBTYPES - list of available subtypes
  * \param[in][out] ids - list of already seen asset ids
+ * \param[in][out] names - names of assets, updated by written asset
+ * \param[in][out] activation - devices requested as active are added here, they are activated by caller
+ * \param[in][out] batch - if set, new asset is not written but added to the batch
+ * \param[out] changed - if set, tells whether the asset was written, update equal to DB content is skipped
  *
  */
 static std::pair<db_a_elmnt_t, persist::asset_operation> process_row(
     tntdb::Connection&                conn,
     const CsvMap&                     cm,
+    const ImportColumns&              columns,
     size_t                            row_i,
     const std::map<std::string, int>& TYPES,
     const std::map<std::string, int>& SUBTYPES,
     std::set<a_elmnt_id_t>&           ids,
+    ImportNames&                      names,
     bool                              sanitize,
     size_t                            rc_0,
     LIMITATIONS_STRUCT                limitations,
-    std::string&                      warningMessages)
+    std::string&                      warningMessages,
+    ImportActivation&                 activation,
+    ImportBatch*                      batch   = NULL,
+    bool*                             changed = NULL)
 {
     LOG_START;
     warningMessages = "";
+    if (changed != NULL) {
+        *changed = true;
+    }
 
     log_debug("################ Row number is %zu", row_i);
-    static const std::set<std::string> STATUSES = {"active", "nonactive", "spare", "retired"};
 
     if (0 == limitations.global_configurability) {
         std::string action = TRANSLATE_ME("Asset handling");
@@ -676,7 +778,7 @@ static std::pair<db_a_elmnt_t, persist::asset_operation> process_row(
     }
 
     // get location, powersource etc as name from ext.name
-    auto sanitizedAssetNames = sanitize_row_ext_names(cm, row_i, sanitize);
+    auto sanitizedAssetNames = sanitize_row_ext_names(cm, row_i, sanitize, names);
 
     // This is used to track, which columns had been already processed,
     // because if they was't processed yet,
@@ -693,7 +795,7 @@ static std::pair<db_a_elmnt_t, persist::asset_operation> process_row(
         unused_columns.erase("create_mode");
 
     // because id is definitely not an external attribute
-    auto id_str = unused_columns.count("id") ? cm.get(row_i, "id") : "";
+    auto id_str = columns.id ? cm.get(row_i, columns.id) : "";
     log_debug("id_str = %s, rc_0 = %d", id_str.c_str(), rc_0);
     if (rc_0 != row_i && "rackcontroller-0" == id_str && rc_0 != std::numeric_limits<std::size_t>::max()) {
         // we got RC-0 but it don't match "myself", change it to something else ("")
@@ -708,7 +810,7 @@ static std::pair<db_a_elmnt_t, persist::asset_operation> process_row(
     persist::asset_operation operation = persist::asset_operation::INSERT;
     int64_t                  id        = 0;
     if (!id_str.empty()) {
-        id = DBAssets::name_to_asset_id(id_str);
+        id = names.name_to_asset_id(id_str);
         if (id == -1) {
             bios_throw("element-not-found", id_str.c_str());
         }
@@ -723,19 +825,10 @@ static std::pair<db_a_elmnt_t, persist::asset_operation> process_row(
         operation = persist::asset_operation::UPDATE;
     }
 
-    auto ename = cm.get(row_i, "name");
-    if (ename.empty()) {
-        std::string received = TRANSLATE_ME("empty value");
-        std::string expected = TRANSLATE_ME("unique, non empty value");
-        bios_throw("request-param-bad", "name", received.c_str(), expected.c_str());
-    }
-    if (ename.length() > 50) {
-        std::string received = TRANSLATE_ME("too long string");
-        std::string expected = TRANSLATE_ME("unique string from 1 to 50 characters");
-        bios_throw("request-param-bad", "name", received.c_str(), expected.c_str());
-    }
+    auto ename = cm.get(row_i, columns.name);
+    s_check_name(ename);
     std::string iname;
-    int         rv = DBAssets::extname_to_asset_name(ename, iname);
+    int         rv = names.extname_to_asset_name(ename, iname);
     if (!id_str.empty() && rv == 0) {
         // internal name from DB must be the same as internal name from CSV
         if (iname != id_str) {
@@ -751,35 +844,22 @@ static std::pair<db_a_elmnt_t, persist::asset_operation> process_row(
     }
     unused_columns.erase("name");
 
-    auto type = cm.get_strip(row_i, "type");
+    auto type = cm.get_strip(row_i, columns.type);
     log_debug("type = '%s'", type.c_str());
-    if (TYPES.find(type) == TYPES.end()) {
-        std::string received = type.empty() ? TRANSLATE_ME("empty value") : JSONIFY(type.c_str());
-        std::string expected = JSONIFY(utils::join_keys_map(TYPES, ", ").c_str());
-        bios_throw("request-param-bad", "type", received.c_str(), expected.c_str());
-    }
-    auto type_id = TYPES.find(type)->second;
+    auto type_id = s_check_type(type, TYPES);
     unused_columns.erase("type");
 
-    auto status = cm.get_strip(row_i, "status");
+    auto status = cm.get_strip(row_i, columns.status);
     log_debug("status = '%s'", status.c_str());
-    if (STATUSES.find(status) == STATUSES.end()) {
-        std::string received = status.empty() ? TRANSLATE_ME("empty value") : JSONIFY(status.c_str());
-        std::string expected = JSONIFY(fty::implode(STATUSES, ", ").c_str());
-        bios_throw("request-param-bad", "status", received.c_str(), expected.c_str());
-    }
+    s_check_status(status);
     unused_columns.erase("status");
 
-    auto asset_tag = unused_columns.count("asset_tag") ? cm.get(row_i, "asset_tag") : "";
+    auto asset_tag = columns.asset_tag ? cm.get(row_i, columns.asset_tag) : "";
     log_debug("asset_tag = '%s'", asset_tag.c_str());
-    if (asset_tag.length() > 50) {
-        std::string received = TRANSLATE_ME("too long string");
-        std::string expected = TRANSLATE_ME("unique string from 1 to 50 characters");
-        bios_throw("request-param-bad", "asset_tag", received.c_str(), expected.c_str());
-    }
+    s_check_asset_tag(asset_tag);
     unused_columns.erase("asset_tag");
 
-    int priority = get_priority(cm.get_strip(row_i, "priority"));
+    int priority = get_priority(cm.get_strip(row_i, columns.priority));
     log_debug("priority = %d", priority);
     unused_columns.erase("priority");
 
@@ -787,9 +867,9 @@ static std::pair<db_a_elmnt_t, persist::asset_operation> process_row(
     log_debug("location = '%s'", location.c_str());
     a_elmnt_id_t parent_id = 0;
     if (!location.empty()) {
-        auto ret = select_asset_element_by_name(conn, location.c_str());
+        auto ret = names.select_id_by_name(conn, location);
         if (ret.status == 1)
-            parent_id = ret.item.id;
+            parent_id = ret.item;
         else {
             if (ret.errsubtype == DB_ERROR_NOTFOUND) {
                 std::string expected = TRANSLATE_ME("<existing asset name>");
@@ -802,38 +882,14 @@ static std::pair<db_a_elmnt_t, persist::asset_operation> process_row(
     }
     unused_columns.erase("location");
 
-    // Business requirement: be able to write 'rack controller', 'RC', 'rc' as subtype == 'rack controller'
-    std::map<std::string, int> local_SUBTYPES     = SUBTYPES;
-    int                        rack_controller_id = SUBTYPES.find("rack controller")->second;
-    int                        patch_panel_id     = SUBTYPES.find("patch panel")->second;
-
-    local_SUBTYPES.emplace(std::make_pair("rackcontroller", rack_controller_id));
-    local_SUBTYPES.emplace(std::make_pair("rackcontroler", rack_controller_id));
-    local_SUBTYPES.emplace(std::make_pair("rc", rack_controller_id));
-    local_SUBTYPES.emplace(std::make_pair("RC", rack_controller_id));
-    local_SUBTYPES.emplace(std::make_pair("RC3", rack_controller_id));
-
-    local_SUBTYPES.emplace(std::make_pair("patchpanel", patch_panel_id));
-
-    auto subtype = cm.get_strip(row_i, "sub_type");
+    int rack_controller_id = SUBTYPES.find("rack controller")->second;
 
+    auto subtype = cm.get_strip(row_i, columns.sub_type);
     log_debug("subtype = '%s'", subtype.c_str());
-    if ((type == "device") && (local_SUBTYPES.find(subtype) == local_SUBTYPES.cend())) {
-        std::string received = subtype.empty() ? TRANSLATE_ME("empty value") : JSONIFY(subtype.c_str());
-        std::string expected = JSONIFY(utils::join_keys_map(SUBTYPES, ", ").c_str());
-        bios_throw("request-param-bad", "subtype", received.c_str(), expected.c_str());
-    }
-
+    auto subtype_id = s_check_subtype(type, subtype, SUBTYPES);
     if ((!subtype.empty()) && (type != "device") && (type != "group")) {
         log_warning("'%s' - subtype is ignored", subtype.c_str());
     }
-
-    if ((subtype.empty()) && (type == "group")) {
-        std::string expected = TRANSLATE_ME("subtype (for type group)");
-        bios_throw("request-param-required", expected.c_str());
-    }
-
-    auto subtype_id = local_SUBTYPES.find(subtype)->second;
     unused_columns.erase("sub_type");
 
     // now we have read all basic information about element
@@ -883,9 +939,9 @@ static std::pair<db_a_elmnt_t, persist::asset_operation> process_row(
         // if group was not specified, just skip it
         if (!group.empty()) {
             // find an id from DB
-            auto ret = select_asset_element_by_name(conn, group.c_str());
+            auto ret = names.select_id_by_name(conn, group);
             if (ret.status == 1)
-                groups.insert(ret.item.id); // if OK, then take ID
+                groups.insert(ret.item); // if OK, then take ID
             else {
                 if (ret.errsubtype == DB_ERROR_NOTFOUND) {
                     log_error("group '%s' is not present in DB, rejected", group.c_str());
@@ -935,9 +991,9 @@ static std::pair<db_a_elmnt_t, persist::asset_operation> process_row(
         if (!link_source.empty()) // if power source is not specified
         {
             // find an id from DB
-            auto ret = select_asset_element_by_name(conn, link_source.c_str());
+            auto ret = names.select_id_by_name(conn, link_source);
             if (ret.status == 1)
-                one_link.src = ret.item.id; // if OK, then take ID
+                one_link.src = ret.item; // if OK, then take ID
             else {
                 if (ret.errsubtype == DB_ERROR_NOTFOUND) {
                     log_warning("power source '%s' is not present in DB, rejected", link_source.c_str());
@@ -1039,30 +1095,15 @@ static std::pair<db_a_elmnt_t, persist::asset_operation> process_row(
     for (auto& key : unused_columns) {
         // try is not needed, because here are keys that are definitely there
         std::string value = cm.get(row_i, key);
-
-        // BIOS-1564: sanitize the date for warranty_end -- start
-        if (is_date(key) && !value.empty()) {
-            char* date = sanitize_date(value.c_str());
-            if (!date) {
-                log_info("Cannot sanitize %s '%s' for device '%s'", key.c_str(), value.c_str(), ename.c_str());
-                std::string expected = TRANSLATE_ME("ISO date");
-                bios_throw("request-param-bad", key.c_str(), value.c_str(), expected.c_str());
-            }
-            if (date) {
-                value = date;
-                zstr_free(&date);
-            }
-        }
-        // BIOS-1564 -- end
+        s_sanitize_ext_value(key, value, ename);
 
         // BIOS-2302: Check some attributes for sensors
-        // BIOS-2784: Check max_current, max_power
         if (key == "logical_asset" && !value.empty()) {
             // check, that this asset exists
 
             value = sanitizedAssetNames.at("logical_asset");
 
-            auto ret = select_asset_element_by_name(conn, value.c_str());
+            auto ret = names.select_id_by_name(conn, value);
             if (ret.status == 0) {
                 if (ret.errsubtype == DB_ERROR_NOTFOUND) {
                     log_info("logical_asset '%s' does not present in DB, rejected", value.c_str());
@@ -1075,59 +1116,6 @@ static std::pair<db_a_elmnt_t, persist::asset_operation> process_row(
                 log_info("logical_asset '%s' does not present in DB, rejected", value.c_str());
                 bios_throw("element-not-found", value.c_str());
             }
-        } else if ((key == "calibration_offset_t" || key == "calibration_offset_h") && !value.empty()) {
-            // we want exceptions to propagate to upper layer
-            sanitize_value_double(key, value);
-        } else if ((key == "max_current" || key == "max_power") && !value.empty()) {
-            // we want exceptions to propagate to upper layer
-            double d_value = sanitize_value_double(key, value);
-            if (d_value < 0) {
-                log_info("Extattribute: %s='%s' is neither positive not zero", key.c_str(), value.c_str());
-                std::string expected = TRANSLATE_ME("value must be a not negative number");
-                bios_throw("request-param-bad", key.c_str(), ("'" + value + "'").c_str(), expected.c_str());
-            }
-        }
-        // BIOS-2781
-        if (key == "location_u_pos" && !value.empty()) {
-            unsigned long ul = 0;
-            try {
-                std::size_t pos = 0;
-                ul              = std::stoul(value, &pos);
-                if (pos != value.length()) {
-                    log_info("Extattribute: %s='%s' is not unsigned integer", key.c_str(), value.c_str());
-                    std::string expected = TRANSLATE_ME("value must be an unsigned integer");
-                    bios_throw("request-param-bad", key.c_str(), ("'" + value + "'").c_str(), expected.c_str());
-                }
-            } catch (const std::exception& e) {
-                log_info("Extattribute: %s='%s' is not unsigned integer", key.c_str(), value.c_str());
-                std::string expected = TRANSLATE_ME("value must be an unsigned integer");
-                bios_throw("request-param-bad", "location_u_pos", ("'" + value + "'").c_str(), expected.c_str());
-            }
-            if (ul == 0 || ul > 52) {
-                std::string expected = TRANSLATE_ME("value must be between <1, 52>.");
-                bios_throw("request-param-bad", "location_u_pos", ("'" + value + "'").c_str(), expected.c_str());
-            }
-        }
-        // BIOS-2799
-        if (key == "u_size" && !value.empty()) {
-            unsigned long ul = 0;
-            try {
-                std::size_t pos = 0;
-                ul              = std::stoul(value, &pos);
-                if (pos != value.length()) {
-                    log_info("Extattribute: %s='%s' is not unsigned integer", key.c_str(), value.c_str());
-                    std::string expected = TRANSLATE_ME("value must be an unsigned integer");
-                    bios_throw("request-param-bad", key.c_str(), ("'" + value + "'").c_str(), expected.c_str());
-                }
-            } catch (const std::exception& e) {
-                log_info("Extattribute: %s='%s' is not unsigned integer", key.c_str(), value.c_str());
-                std::string expected = TRANSLATE_ME("value must be an unsigned integer");
-                bios_throw("request-param-bad", "u_size", ("'" + value + "'").c_str(), expected.c_str());
-            }
-            if (ul == 0 || ul > 52) {
-                std::string expected = TRANSLATE_ME("value must be between <1, 52>.");
-                bios_throw("request-param-bad", "u_size", ("'" + value + "'").c_str(), expected.c_str());
-            }
         }
 
         if (match_ext_attr(value, key)) {
@@ -1172,7 +1160,14 @@ static std::pair<db_a_elmnt_t, persist::asset_operation> process_row(
             zhash_insert(extattributesRO, "update_user", const_cast<char*>(cm.getUpdateUser().c_str()));
         m.id               = uint32_t(id);
         std::string errmsg = "";
-        if (type != "device") {
+        if (is_asset_unchanged(conn, m.id, iname.c_str(), parent_id, extattributes, status.c_str(),
+                uint16_t(priority), groups, type == "device" ? &links : NULL, asset_tag)) {
+            // nothing is written, the row is reported as imported anyway
+            log_debug("element '%s' is unchanged", ename.c_str());
+            if (changed != NULL) {
+                *changed = false;
+            }
+        } else if (type != "device") {
             auto ret = update_dc_room_row_rack_group(
                 conn, m.id, iname.c_str(), uint16_t(type_id), parent_id, extattributes, status.c_str(),
                 uint16_t(priority), groups, asset_tag, errmsg, extattributesRO);
@@ -1187,10 +1182,7 @@ static std::pair<db_a_elmnt_t, persist::asset_operation> process_row(
                 if (currentStatus == "active") // unactive the asset
                 {
                     try {
-                        mlm::MlmSyncClient  client(AGENT_FTY_ASSET, AGENT_ASSET_ACTIVATOR);
-                        fty::AssetActivator activationAccessor(client);
-                        std::string         asset_json = getJsonAsset(NULL, m.id);
-                        activationAccessor.deactivate(asset_json);
+                        activation.deactivate(conn, m.id);
                     } catch (const std::exception& e) {
                         std::string err = JSONIFY(e.what());
                         bios_throw("licensing-err", err.c_str())
@@ -1215,17 +1207,9 @@ static std::pair<db_a_elmnt_t, persist::asset_operation> process_row(
                 }
 
 
-                if (requestedStatus == "active") // active the asset
+                if (requestedStatus == "active") // active the asset once the import is done
                 {
-                    try {
-                        mlm::MlmSyncClient  client(AGENT_FTY_ASSET, AGENT_ASSET_ACTIVATOR);
-                        fty::AssetActivator activationAccessor(client);
-                        std::string         asset_json = getJsonAsset(NULL, m.id);
-                        activationAccessor.activate(asset_json);
-                    } catch (const std::exception& e) {
-                        warningMessages += TRANSLATE_ME(
-                            "Element '%s' is updated but a licensing error occured: %s", id_str.c_str(), e.what());
-                    }
+                    activation.add(m.id, id_str);
                 }
             } else {
                 tntdb::Transaction trans(conn);
@@ -1244,6 +1228,36 @@ static std::pair<db_a_elmnt_t, persist::asset_operation> process_row(
             zhash_insert(extattributesRO, "create_mode", const_cast<char*>(std::to_string(cm.getCreateMode()).c_str()));
         if (cm.getCreateUser() != "")
             zhash_insert(extattributesRO, "create_user", const_cast<char*>(cm.getCreateUser().c_str()));
+        if (batch != NULL) {
+            // written later together with other new assets
+            ImportRow row;
+            row.row_i        = row_i;
+            row.ename        = ename;
+            row.groups       = groups;
+            row.links        = links;
+            row.activate     = type == "device" && subtype_id != rack_controller_id && status == "active";
+            row.write_status = row.activate ? "nonactive" : status;
+
+            row.element            = m;
+            row.element.id         = 0;
+            row.element.status     = row.write_status;
+            row.element.parent_id  = parent_id;
+            row.element.priority   = uint16_t(priority);
+            row.element.type_id    = uint16_t(type_id);
+            row.element.subtype_id = uint16_t(subtype_id);
+            row.element.asset_tag  = asset_tag;
+            for (void* it = zhash_first(extattributes); it != NULL; it = zhash_next(extattributes)) {
+                row.element.ext.emplace(zhash_cursor(extattributes), static_cast<const char*>(it));
+            }
+            for (void* it = zhash_first(extattributesRO); it != NULL; it = zhash_next(extattributesRO)) {
+                row.ext_ro.emplace(zhash_cursor(extattributesRO), static_cast<const char*>(it));
+            }
+
+            auto ret = std::make_pair(row.element, operation);
+            batch->add(std::move(row));
+            LOG_END;
+            return ret;
+        }
         if (type != "device") {
             // this is a transaction
             auto ret = insert_dc_room_row_rack_group(
@@ -1275,16 +1289,8 @@ static std::pair<db_a_elmnt_t, persist::asset_operation> process_row(
                 }
 
                 if (requestedStatus == "active") {
-                    // try to activate the device
-                    try {
-                        std::string         asset_json = getJsonAsset(NULL, m.id);
-                        mlm::MlmSyncClient  client(AGENT_FTY_ASSET, AGENT_ASSET_ACTIVATOR);
-                        fty::AssetActivator activationAccessor(client);
-                        activationAccessor.activate(asset_json);
-                    } catch (const std::exception& e) {
-                        warningMessages += TRANSLATE_ME(
-                            "Element '%s' is updated but a licensing error occured: %s", id_str.c_str(), e.what());
-                    }
+                    // activate the device once the import is done
+                    activation.add(m.id, id_str);
                 }
             } else {
                 // this is a transaction
@@ -1300,10 +1306,24 @@ static std::pair<db_a_elmnt_t, persist::asset_operation> process_row(
         }
     }
 
-    rv = DBAssets::extname_to_asset_name(ename, m.name);
-    if (rv != 0) {
-        std::string err = TRANSLATE_ME("Database failure");
-        bios_throw("internal-error", err.c_str());
+    if (!id_str.empty()) {
+        // updated asset keeps its internal name
+        m.name = id_str;
+    } else {
+        // internal name of new asset is assigned by DB
+        try {
+            conn.prepareCached(" SELECT name FROM t_bios_asset_element WHERE id_asset_element = :id")
+                .set("id", m.id)
+                .selectValue()
+                .get(m.name);
+        } catch (const std::exception& e) {
+            log_error("cannot read name of asset %" PRIu32 ": %s", m.id, e.what());
+            std::string err = TRANSLATE_ME("Database failure");
+            bios_throw("internal-error", err.c_str());
+        }
+    }
+    if (names.loaded()) {
+        names.update(m.id, m.name, ename);
     }
 
     m.status     = status;
@@ -1348,6 +1368,247 @@ static std::string              mandatory_missing(const CsvMap& cm)
     return "";
 }
 
+/*
+ * \brief Rejects the import if some of mandatory columns is missing
+ */
+static void s_require_mandatory(const CsvMap& cm)
+{
+    auto m = mandatory_missing(cm);
+    if (m != "") {
+        std::string msg{"column '" + m + "' is missing, import is aborted"};
+        log_error("%s", msg.c_str());
+        LOG_END;
+        std::string msg_received = TRANSLATE_ME("<missing column '%s'>", m.c_str());
+        std::string msg_expected = TRANSLATE_ME("<column '%s' is present in csv>", m.c_str());
+        bios_throw("request-param-bad", m.c_str(), msg_received.c_str(), msg_expected.c_str());
+    }
+}
+
+/*
+ * \brief Returns cached type dictionaries, throws if they cannot be read from DB
+ */
+static std::shared_ptr<const AssetDictionary::Snapshot> s_dictionary(const std::string& msg)
+{
+    auto dictionary = AssetDictionary::get();
+    if (dictionary->types.empty() || dictionary->subtypes.empty())
+        bios_throw("internal-error", msg.c_str());
+    return dictionary;
+}
+
+/*
+ * \brief Connects to DB and takes the dictionaries every import needs
+ */
+static std::shared_ptr<const AssetDictionary::Snapshot> s_import_prepare(tntdb::Connection& conn)
+{
+    std::string msg{TRANSLATE_ME("No connection to database")};
+    try {
+        conn = tntdb::connect(DBConn::url);
+    } catch (...) {
+        log_error("%s", msg.c_str());
+        LOG_END;
+        bios_throw("internal-error", msg.c_str());
+    }
+
+    return s_dictionary(msg);
+}
+
+/*
+ * \brief Marks the csv map as created by csv import of given user
+ */
+static void s_set_import_user(CsvMap& cm, const std::string& user, const std::string& timestamp)
+{
+    cm.setCreateMode(CREATE_MODE_CSV);
+    cm.setCreateUser(user);
+    cm.setUpdateUser(user);
+    if (!timestamp.empty()) {
+        cm.setUpdateTs(timestamp);
+    }
+}
+
+static std::string s_import_timestamp()
+{
+    std::time_t timestamp = std::time(NULL);
+    char        mbstr[100];
+    if (std::strftime(mbstr, sizeof(mbstr), "%FT%T%z", std::localtime(&timestamp))) {
+        return std::string(mbstr);
+    }
+    return "";
+}
+
+/*
+ * \brief Row written by import which waits for activation of the device
+ */
+struct ActivatedRow
+{
+    size_t                                            row_i;
+    std::pair<db_a_elmnt_t, persist::asset_operation> ret;
+    std::string                                       warningMessages; // issues found by process_row
+};
+
+/*
+ * \brief Activates all collected devices and reports their rows as processed rows are reported
+ */
+static void s_flush_activation(
+    tntdb::Connection&                                              conn,
+    ImportActivation&                                               activation,
+    std::map<a_elmnt_id_t, ActivatedRow>&                           activated,
+    std::vector<std::pair<db_a_elmnt_t, persist::asset_operation>>& okRows,
+    std::map<int, std::string>&                                     failRows)
+{
+    activation.flush(conn, [&](a_elmnt_id_t id, const std::string& warning) {
+        const ActivatedRow& row             = activated.at(id);
+        std::string         warningMessages = row.warningMessages + warning;
+        if (warningMessages.empty()) {
+            okRows.push_back(row.ret);
+            log_info("row %zu was imported successfully", row.row_i);
+        } else {
+            failRows.insert(std::make_pair(row.row_i + 1, warningMessages));
+            log_error("row %zu imported with issue: %s", row.row_i, warningMessages.c_str());
+        }
+    });
+    activated.clear();
+}
+
+/*
+ * \brief Runs all checks of process_row which need no DB on one row
+ */
+static void s_validate_row(
+    const CsvMap&                     cm,
+    const ImportColumns&              columns,
+    size_t                            row_i,
+    const std::map<std::string, int>& TYPES,
+    const std::map<std::string, int>& SUBTYPES)
+{
+    auto ename = cm.get(row_i, columns.name);
+    s_check_name(ename);
+    auto type = cm.get_strip(row_i, columns.type);
+    s_check_type(type, TYPES);
+    s_check_status(cm.get_strip(row_i, columns.status));
+    if (columns.asset_tag) {
+        s_check_asset_tag(cm.get(row_i, columns.asset_tag));
+    }
+    s_check_subtype(type, cm.get_strip(row_i, columns.sub_type), SUBTYPES);
+    for (size_t col_i = 0; col_i != cm.cols(); ++col_i) {
+        std::string value = cm.get(row_i, cm.column_at(col_i));
+        s_sanitize_ext_value(cm.titles()[col_i], value, ename);
+    }
+}
+
+// files smaller than this are checked by one thread
+static const size_t VALIDATE_ROWS_PER_THREAD = 1000;
+
+/*
+ * \brief Checks all rows of csv in parallel, nothing is read from DB
+ *
+ * \return rejected rows with the reason
+ */
+static std::map<size_t, std::string> s_validate_rows(
+    const CsvMap& cm, const std::map<std::string, int>& TYPES, const std::map<std::string, int>& SUBTYPES)
+{
+    const ImportColumns columns{cm};
+    const size_t        rows    = cm.rows() > 0 ? cm.rows() - 1 : 0; // without title row
+    const size_t        threads = std::max<size_t>(1,
+        std::min<size_t>(std::thread::hardware_concurrency(), rows / VALIDATE_ROWS_PER_THREAD));
+
+    // every thread checks continuous range of rows and writes into its own map, other errors stop it and are
+    // thrown by the caller once all threads are done
+    std::vector<std::map<size_t, std::string>> rejected(threads);
+    std::vector<std::exception_ptr>            errors(threads);
+    auto                                       check = [&](size_t thread_i) {
+        try {
+            const size_t end = 1 + rows * (thread_i + 1) / threads;
+            for (size_t row_i = 1 + rows * thread_i / threads; row_i != end; ++row_i) {
+                try {
+                    s_validate_row(cm, columns, row_i, TYPES, SUBTYPES);
+                } catch (const std::invalid_argument& e) {
+                    rejected[thread_i].emplace(row_i, e.what());
+                } catch (const std::out_of_range&) {
+                    // short row, reported by process_row
+                }
+            }
+        } catch (...) {
+            errors[thread_i] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t thread_i = 1; thread_i < threads; ++thread_i) {
+        workers.emplace_back(check, thread_i);
+    }
+    check(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    for (size_t thread_i = 1; thread_i < threads; ++thread_i) {
+        rejected[0].insert(rejected[thread_i].begin(), rejected[thread_i].end());
+    }
+    log_debug("%zu rows checked by %zu threads, %zu rejected", rows, threads, rejected[0].size());
+    return std::move(rejected[0]);
+}
+
+/*
+ * \brief Reads the whole csv file into the map
+ */
+static CsvMap s_read_csv(std::istream& input)
+{
+    std::string buffer    = CsvDocument::read_all(input);
+    char        delimiter = findDelimiter(buffer);
+    if (delimiter == '\x0') {
+        std::string msg{TRANSLATE_ME("Cannot detect the delimiter, use comma (,) semicolon (;) or tabulator")};
+        log_error("%s", msg.c_str());
+        bios_throw("bad-request-document", msg.c_str());
+    }
+    log_debug("Using delimiter '%c'", delimiter);
+    CsvMap cm{CsvDocument{std::move(buffer), delimiter}};
+    cm.deserialize();
+    return cm;
+}
+
+void validate_asset_csv(std::istream& input, std::map<int, std::string>& failRows)
+{
+    LOG_START;
+
+    CsvMap cm = s_read_csv(input);
+    s_require_mandatory(cm);
+
+    tntdb::Connection conn;
+    auto              dictionary = s_import_prepare(conn);
+    const auto&       TYPES      = dictionary->types;
+    const auto&       SUBTYPES   = dictionary->subtypes;
+
+    for (const auto& it : s_validate_rows(cm, TYPES, SUBTYPES)) {
+        failRows.insert(std::make_pair(it.first + 1, it.second));
+    }
+    LOG_END;
+}
+
+// bigger input is imported by load_asset_csv_stream, the whole file is held in memory several times over otherwise
+static const std::streamoff STREAM_IMPORT_SIZE = 32 * 1024 * 1024;
+
+// amount of csv tokenized at once by load_asset_csv_stream
+static const size_t STREAM_BATCH_SIZE = 1024 * 1024;
+
+/*
+ * \brief return the size of the rest of the stream or -1 if the stream can't tell
+ */
+static std::streamoff s_remaining_size(std::istream& input)
+{
+    auto pos = input.tellg();
+    if (pos == std::streampos(-1)) {
+        return -1;
+    }
+    input.seekg(0, std::ios::end);
+    auto end = input.tellg();
+    input.seekg(pos);
+    return end == std::streampos(-1) ? -1 : std::streamoff(end - pos);
+}
+
 void load_asset_csv(
     std::istream&                                                   input,
     std::vector<std::pair<db_a_elmnt_t, persist::asset_operation>>& okRows,
@@ -1357,31 +1618,277 @@ void load_asset_csv(
 {
     LOG_START;
 
-    std::vector<std::vector<std::string>> data;
-    cxxtools::CsvDeserializer             deserializer(input);
-    char                                  delimiter = findDelimiter(input);
-    if (delimiter == '\x0') {
+    if (s_remaining_size(input) > STREAM_IMPORT_SIZE) {
+        log_info("csv is bigger than %lld bytes, it is imported row by row", (long long)STREAM_IMPORT_SIZE);
+        load_asset_csv_stream(input, okRows, failRows, touch_fn, user);
+        LOG_END;
+        return;
+    }
+
+    CsvMap cm = s_read_csv(input);
+    s_set_import_user(cm, user, s_import_timestamp());
+    return load_asset_csv(cm, okRows, failRows, touch_fn);
+}
+
+/*
+ * \brief return the column of the row which refers to an asset not known yet, nullptr if there is none
+ *
+ * \param[in] known - tells if the asset of the name normalized by ImportPlan::key is known
+ */
+static const ColumnHandle* s_unresolved(const CsvMap& cm, size_t row_i, const std::vector<ColumnHandle>& references,
+    const std::function<bool(const std::string&)>& known)
+{
+    for (const auto& column : references) {
+        std::string_view name;
+        try {
+            name = cm.cell(row_i, column);
+        } catch (const std::out_of_range&) {
+            // short row is reported by process_row
+            continue;
+        }
+        if (name.empty() || known(ImportPlan::key(name))) {
+            continue;
+        }
+        // power source being myself is ignored by the import
+        bool self = false;
+        for (const auto& own : {cm.column("name"), cm.column("id")}) {
+            try {
+                self = self || (own && ImportPlan::key(cm.cell(row_i, own)) == ImportPlan::key(name));
+            } catch (const std::out_of_range&) {
+            }
+        }
+        if (!self) {
+            return &column;
+        }
+    }
+    return nullptr;
+}
+
+/*
+ * \brief return cells of the row up to the last column with a title
+ */
+static std::vector<std::string> s_row_cells(const CsvMap& cm, size_t row_i)
+{
+    std::vector<std::string> cells;
+    try {
+        for (size_t col_i = 0; col_i != cm.cols(); ++col_i) {
+            cells.emplace_back(cm.cell(row_i, cm.column_at(col_i)));
+        }
+    } catch (const std::out_of_range&) {
+        // short row stays short
+    }
+    return cells;
+}
+
+void load_asset_csv_stream(
+    std::istream&                                                   input,
+    std::vector<std::pair<db_a_elmnt_t, persist::asset_operation>>& okRows,
+    std::map<int, std::string>&                                     failRows,
+    touch_cb_t                                                      touch_fn,
+    std::string                                                     user)
+{
+    LOG_START;
+
+    // every batch starts with the title row, so it is imported as a csv map of its own
+    CsvRowReader reader{input, STREAM_BATCH_SIZE, true};
+    if (reader.delimiter() == '\x0') {
         std::string msg{TRANSLATE_ME("Cannot detect the delimiter, use comma (,) semicolon (;) or tabulator")};
         log_error("%s", msg.c_str());
         LOG_END;
         bios_throw("bad-request-document", msg.c_str());
     }
-    log_debug("Using delimiter '%c'", delimiter);
-    deserializer.delimiter(delimiter);
-    deserializer.readTitle(false);
-    deserializer.deserialize(data);
-    CsvMap cm{data};
-    cm.deserialize();
+    log_debug("Using delimiter '%c'", reader.delimiter());
 
-    cm.setCreateMode(CREATE_MODE_CSV);
-    cm.setCreateUser(user);
-    cm.setUpdateUser(user);
-    std::time_t timestamp = std::time(NULL);
-    char        mbstr[100];
-    if (std::strftime(mbstr, sizeof(mbstr), "%FT%T%z", std::localtime(&timestamp))) {
-        cm.setUpdateTs(std::string(mbstr));
+    CsvDocument chunk;
+    if (!reader.next(chunk)) {
+        std::string err = TRANSLATE_ME("Cannot import empty document.");
+        bios_throw("bad-request-document", err.c_str());
     }
-    return load_asset_csv(cm, okRows, failRows, touch_fn);
+
+    tntdb::Connection conn;
+    auto              dictionary = s_import_prepare(conn);
+    const auto&       TYPES      = dictionary->types;
+    const auto&       SUBTYPES   = dictionary->subtypes;
+
+    std::set<a_elmnt_id_t> ids{};
+    size_t                 rc0 = std::numeric_limits<std::size_t>::max();
+    LIMITATIONS_STRUCT     limitations;
+    get_licensing_limitation(limitations);
+
+    ImportNames names;
+    names.load(conn);
+
+    // process wide indexes re-read updated assets in groups, not after every row
+    DeferredChanges changes{conn};
+
+    const std::string timestamp = s_import_timestamp();
+
+    ImportActivation                     activation;
+    std::map<a_elmnt_id_t, ActivatedRow> activated;
+
+    // without names everything goes to DB and fails there
+    auto known = [&names](const std::string& key) {
+        return !names.loaded() || names.exists_key(key);
+    };
+
+    // new assets are written in batches, line_of tells the line of a row of the csv map the batch is filled from
+    ImportBatch                   batch{names};
+    std::function<size_t(size_t)> line_of;
+    auto                          known_or_batched = [&known, &batch](const std::string& key) {
+        return known(key) || batch.contains_key(key);
+    };
+    auto batch_ok = [&](ImportRow& row) {
+        size_t line = line_of(row.row_i);
+        touch_fn();
+        if (row.activate) {
+            activation.add(row.element.id, row.ename);
+            activated[row.element.id] =
+                ActivatedRow{line, std::make_pair(row.element, persist::asset_operation::INSERT), ""};
+        } else {
+            okRows.push_back(std::make_pair(row.element, persist::asset_operation::INSERT));
+            log_info("row %zu was imported successfully", line);
+        }
+    };
+    auto batch_fail = [&](size_t row_i, const std::string& msg) {
+        failRows.insert(std::make_pair(line_of(row_i) + 1, msg));
+        touch_fn();
+    };
+
+    // line is the number of data row in the whole file, failed row is reported in failRows under it
+    auto import_row = [&](const CsvMap& cm, const ImportColumns& columns, size_t row_i, size_t line) {
+        try {
+            std::string warningMessages;
+            bool        changed = true;
+            auto        ret     = process_row(conn, cm, columns, row_i, TYPES, SUBTYPES, ids, names, true, rc0,
+                limitations, warningMessages, activation, &batch, &changed);
+            if (batch.contains(row_i)) {
+                if (batch.full()) {
+                    batch.flush(conn, batch_ok, batch_fail);
+                }
+                return;
+            }
+            touch_fn();
+            if (activation.contains(ret.first.id)) {
+                activated[ret.first.id] = ActivatedRow{line, ret, warningMessages};
+            } else if (warningMessages.empty()) {
+                // row equal to DB is not written, still it was imported
+                okRows.push_back(ret);
+                if (changed) {
+                    log_info("row %zu was imported successfully", line);
+                } else {
+                    log_info("row %zu is unchanged", line);
+                }
+            } else {
+                failRows.insert(std::make_pair(line + 1, warningMessages));
+                log_error("row %zu imported with issue: %s", line, warningMessages.c_str());
+            }
+        } catch (const std::invalid_argument& e) {
+            failRows[int(line + 1)] = e.what();
+            log_error("row %zu not imported: %s", line, e.what());
+            touch_fn();
+        }
+    };
+
+    // return false if the row refers to an asset not known yet, a row referring to a batched one writes the batch
+    auto try_import = [&](const CsvMap& cm, const ImportColumns& columns, const std::vector<ColumnHandle>& references,
+                          size_t row_i, size_t line) {
+        if (s_unresolved(cm, row_i, references, known_or_batched)) {
+            return false;
+        }
+        if (!batch.empty() && s_unresolved(cm, row_i, references, known)) {
+            batch.flush(conn, batch_ok, batch_fail);
+        }
+        import_row(cm, columns, row_i, line);
+        return true;
+    };
+
+    auto reference_columns = [](const CsvMap& cm) {
+        std::vector<ColumnHandle> references;
+        for (size_t col_i = 0; col_i != cm.cols(); ++col_i) {
+            if (ImportPlan::is_reference(cm.titles()[col_i])) {
+                references.push_back(cm.column_at(col_i));
+            }
+        }
+        return references;
+    };
+
+    // rows referring to an asset defined later in the file wait for it, only those are kept in memory
+    CsvMap::Data        deferred;
+    std::vector<size_t> deferred_lines{0};
+    size_t              line = 0;
+    do {
+        CsvMap cm{std::move(chunk)};
+        cm.deserialize();
+        if (deferred.empty()) {
+            s_require_mandatory(cm);
+            deferred.push_back(s_row_cells(cm, 0));
+        }
+        s_set_import_user(cm, user, timestamp);
+        const ImportColumns columns{cm};
+        const auto          references = reference_columns(cm);
+        const size_t        first_line = line;
+        line_of                        = [first_line](size_t row_i) {
+            return first_line + row_i;
+        };
+
+        // rows failing checks which need no DB are rejected before anything of the chunk is written
+        auto rejected = s_validate_rows(cm, TYPES, SUBTYPES);
+        for (size_t row_i = 1; row_i != cm.rows(); ++row_i) {
+            ++line;
+            auto it = rejected.find(row_i);
+            if (it != rejected.end()) {
+                failRows.insert(std::make_pair(line + 1, it->second));
+                log_error("row %zu not imported: %s", line, it->second.c_str());
+                touch_fn();
+                continue;
+            }
+            if (!try_import(cm, columns, references, row_i, line)) {
+                deferred.push_back(s_row_cells(cm, row_i));
+                deferred_lines.push_back(line);
+            }
+        }
+        // batch refers to rows of this chunk
+        batch.flush(conn, batch_ok, batch_fail);
+    } while (reader.next(chunk));
+
+    if (deferred.size() > 1) {
+        log_debug("%zu rows wait for assets defined later in the file", deferred.size() - 1);
+        CsvMap cm{deferred};
+        cm.deserialize();
+        s_set_import_user(cm, user, timestamp);
+        const ImportColumns columns{cm};
+        const auto          references = reference_columns(cm);
+        line_of                        = [&deferred_lines](size_t row_i) {
+            return deferred_lines[row_i];
+        };
+
+        std::vector<bool> imported(cm.rows(), false);
+        bool              somethingProcessed = true;
+        while (somethingProcessed) {
+            somethingProcessed = false;
+            for (size_t row_i = 1; row_i != cm.rows(); ++row_i) {
+                if (!imported[row_i] && try_import(cm, columns, references, row_i, deferred_lines[row_i])) {
+                    imported[row_i]    = true;
+                    somethingProcessed = true;
+                }
+            }
+            // assets of this pass are known to the next one
+            batch.flush(conn, batch_ok, batch_fail);
+        }
+        for (size_t row_i = 1; row_i != cm.rows(); ++row_i) {
+            const ColumnHandle* column = imported[row_i] ? nullptr : s_unresolved(cm, row_i, references, known);
+            if (column) {
+                std::string msg = TRANSLATE_ME("Element '%s' referred in column '%s' does not exist",
+                    cm.get(row_i, *column).c_str(), cm.title(*column).c_str());
+                failRows[int(deferred_lines[row_i] + 1)] = msg;
+                log_error("row %zu not imported: %s", deferred_lines[row_i], msg.c_str());
+                touch_fn();
+            }
+        }
+    }
+    changes.flush();
+    s_flush_activation(conn, activation, activated, okRows, failRows);
+    LOG_END;
 }
 
 std::pair<db_a_elmnt_t, persist::asset_operation> process_one_asset(const CsvMap& cm)
@@ -1406,13 +1913,9 @@ std::pair<db_a_elmnt_t, persist::asset_operation> process_one_asset(const CsvMap
         bios_throw("internal-error", msg.c_str());
     }
 
-    auto TYPES = read_element_types(conn);
-    if (TYPES.empty())
-        bios_throw("internal-error", msg.c_str());
-
-    auto SUBTYPES = read_device_types(conn);
-    if (SUBTYPES.empty())
-        bios_throw("internal-error", msg.c_str());
+    auto        dictionary = s_dictionary(msg);
+    const auto& TYPES      = dictionary->types;
+    const auto& SUBTYPES   = dictionary->subtypes;
 
     std::set<a_elmnt_id_t> ids{};
     int                    rc_0           = -1;
@@ -1430,8 +1933,17 @@ std::pair<db_a_elmnt_t, persist::asset_operation> process_one_asset(const CsvMap
     }
     LIMITATIONS_STRUCT limitations;
     get_licensing_limitation(limitations);
-    std::string warningMessage;
-    auto        ret = process_row(conn, cm, 1, TYPES, SUBTYPES, ids, true, size_t(rc_0), limitations, warningMessage);
+    std::string      warningMessage;
+    ImportColumns    columns{cm};
+    ImportNames      names; // one row only, resolve in DB
+    ImportActivation activation;
+    auto             ret = process_row(conn, cm, columns, 1, TYPES, SUBTYPES, ids, names, true, size_t(rc_0),
+        limitations, warningMessage, activation);
+    activation.flush(conn, [](a_elmnt_id_t, const std::string& warning) {
+        if (!warning.empty()) {
+            log_warning("%s", warning.c_str());
+        }
+    });
     LOG_END;
     return ret;
 }
@@ -1444,34 +1956,12 @@ void load_asset_csv(
 {
     LOG_START;
 
-    auto m = mandatory_missing(cm);
-    if (m != "") {
-        std::string msg{"column '" + m + "' is missing, import is aborted"};
-        log_error("%s", msg.c_str());
-        LOG_END;
-        std::string msg_received = TRANSLATE_ME("<missing column '%s'>", m.c_str());
-        std::string msg_expected = TRANSLATE_ME("<column '%s' is present in csv>", m.c_str());
-        bios_throw("request-param-bad", m.c_str(), msg_received.c_str(), msg_expected.c_str());
-    }
+    s_require_mandatory(cm);
 
     tntdb::Connection conn;
-    std::string       msg{TRANSLATE_ME("No connection to database")};
-    try {
-        conn = tntdb::connect(DBConn::url);
-    } catch (...) {
-        log_error("%s", msg.c_str());
-        LOG_END;
-        bios_throw("internal-error", msg.c_str());
-    }
-
-    auto TYPES = read_element_types(conn);
-
-    if (TYPES.empty())
-        bios_throw("internal-error", msg.c_str());
-
-    auto SUBTYPES = read_device_types(conn);
-    if (SUBTYPES.empty())
-        bios_throw("internal-error", msg.c_str());
+    auto              dictionary = s_import_prepare(conn);
+    const auto&       TYPES      = dictionary->types;
+    const auto&       SUBTYPES   = dictionary->subtypes;
 
     // BIOS-2506
     std::set<a_elmnt_id_t> ids{};
@@ -1486,34 +1976,107 @@ void load_asset_csv(
     LIMITATIONS_STRUCT limitations;
     get_licensing_limitation(limitations);
 
-    std::set<size_t> processedRows;
-    bool             somethingProcessed;
-    do {
-        somethingProcessed = false;
-        failRows.clear();
-        for (size_t row_i = 1; row_i != cm.rows(); ++row_i) {
-            if (processedRows.find(row_i) != processedRows.end())
-                continue;
-            try {
-                std::string warningMessages;
-                auto ret = process_row(conn, cm, row_i, TYPES, SUBTYPES, ids, true, rc0, limitations, warningMessages);
+    // names of assets already in DB, references to anything else must be defined by the csv
+    ImportNames names;
+    names.load(conn);
+    ImportPlan plan{cm, [&names](const std::string& key) {
+                        return !names.loaded() || names.exists_key(key);
+                    }};
+
+    // rows failing checks which need no DB are rejected before anything is written
+    std::set<size_t> failedRows;
+    for (const auto& rejected : {s_validate_rows(cm, TYPES, SUBTYPES), plan.rejected()}) {
+        for (const auto& it : rejected) {
+            if (failedRows.insert(it.first).second) {
+                failRows.insert(std::make_pair(it.first + 1, it.second));
+                log_error("row %zu not imported: %s", it.first, it.second.c_str());
                 touch_fn();
-                if (warningMessages.empty()) {
-                    okRows.push_back(ret);
+            }
+        }
+    }
+
+    // process wide indexes re-read updated assets in groups, not after every row
+    DeferredChanges changes{conn};
+
+    // every row is processed exactly once, after all rows it refers to
+    // new assets are written in batches, rows referring to them wait until the batch is written
+    // devices requested as active are reported once all of them are activated at the end
+    ImportActivation                     activation;
+    std::map<a_elmnt_id_t, ActivatedRow> activated;
+
+    ImportBatch batch{names};
+    auto        batch_ok = [&](ImportRow& row) {
+        touch_fn();
+        if (row.activate) {
+            activation.add(row.element.id, row.ename);
+            activated[row.element.id] =
+                ActivatedRow{row.row_i, std::make_pair(row.element, persist::asset_operation::INSERT), ""};
+        } else {
+            okRows.push_back(std::make_pair(row.element, persist::asset_operation::INSERT));
+            log_info("row %zu was imported successfully", row.row_i);
+        }
+    };
+    auto batch_fail = [&](size_t row_i, const std::string& msg) {
+        failRows.insert(std::make_pair(row_i + 1, msg));
+        failedRows.insert(row_i);
+        touch_fn();
+    };
+
+    ImportColumns columns{cm};
+    for (size_t row_i : plan.order()) {
+        if (failedRows.count(row_i) != 0) {
+            continue;
+        }
+        const auto& deps = plan.dependencies(row_i);
+        if (std::any_of(deps.begin(), deps.end(), [&batch](size_t dep) { return batch.contains(dep); })) {
+            batch.flush(conn, batch_ok, batch_fail);
+        }
+        auto failed_dep =
+            std::find_if(deps.begin(), deps.end(), [&failedRows](size_t dep) { return failedRows.count(dep) != 0; });
+        if (failed_dep != deps.end()) {
+            std::string msg = TRANSLATE_ME("Asset this row refers to (row %zu) was not imported", *failed_dep + 1);
+            failRows.insert(std::make_pair(row_i + 1, msg));
+            failedRows.insert(row_i);
+            log_error("row %zu not imported: %s", row_i, msg.c_str());
+            touch_fn();
+            continue;
+        }
+        try {
+            std::string warningMessages;
+            bool        changed = true;
+            auto        ret     = process_row(conn, cm, columns, row_i, TYPES, SUBTYPES, ids, names, true, rc0,
+                limitations, warningMessages, activation, &batch, &changed);
+            if (batch.contains(row_i)) {
+                if (batch.full()) {
+                    batch.flush(conn, batch_ok, batch_fail);
+                }
+                continue;
+            }
+            touch_fn();
+            if (activation.contains(ret.first.id)) {
+                activated[ret.first.id] = ActivatedRow{row_i, ret, warningMessages};
+            } else if (warningMessages.empty()) {
+                // row equal to DB is not written, still it was imported
+                okRows.push_back(ret);
+                if (changed) {
                     log_info("row %zu was imported successfully", row_i);
                 } else {
-                    failRows.insert(std::make_pair(row_i + 1, warningMessages));
-                    log_error("row %zu imported with issue: %s", row_i, warningMessages.c_str());
+                    log_info("row %zu is unchanged", row_i);
                 }
-
-                somethingProcessed = true;
-                processedRows.insert(row_i);
-            } catch (const std::invalid_argument& e) {
-                failRows.insert(std::make_pair(row_i + 1, e.what()));
-                log_error("row %zu not imported: %s", row_i, e.what());
+            } else {
+                failRows.insert(std::make_pair(row_i + 1, warningMessages));
+                log_error("row %zu imported with issue: %s", row_i, warningMessages.c_str());
             }
+        } catch (const std::invalid_argument& e) {
+            failRows.insert(std::make_pair(row_i + 1, e.what()));
+            failedRows.insert(row_i);
+            log_error("row %zu not imported: %s", row_i, e.what());
+            touch_fn();
         }
-    } while (somethingProcessed);
+    }
+    batch.flush(conn, batch_ok, batch_fail);
+    changes.flush();
+    s_flush_activation(conn, activation, activated, okRows, failRows);
     LOG_END;
 }
 
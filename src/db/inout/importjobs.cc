@@ -0,0 +1,211 @@
+/*
+ *
+ * Copyright (C) 2015 - 2020 Eaton
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "db/inout/importjobs.h"
+#include <fty_common.h>
+#include <sstream>
+#include <stdexcept>
+
+namespace persist {
+
+// thrown by the progress callback of the running import when the queue is stopped
+struct ImportStopped : public std::runtime_error
+{
+    ImportStopped()
+        : std::runtime_error("import was stopped")
+    {
+    }
+};
+
+const char* ImportJobStatus::state_str(State state)
+{
+    switch (state) {
+        case State::QUEUED:
+            return "queued";
+        case State::RUNNING:
+            return "running";
+        case State::DONE:
+            return "done";
+        case State::FAILED:
+            return "failed";
+    }
+    return "unknown";
+}
+
+ImportJobs& ImportJobs::instance()
+{
+    static ImportJobs jobs;
+    return jobs;
+}
+
+ImportJobs::~ImportJobs()
+{
+    // running import stops at its next row, so the process exit does not wait for it to finish
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _cond.notify_all();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+std::string ImportJobs::submit(std::string&& csv, const std::string& user, const done_fn& done)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_queue.size() >= MAX_QUEUED || _queued_bytes + csv.size() > MAX_QUEUED_BYTES) {
+        log_error("import of user '%s' rejected, %zu jobs with %zu bytes of csv are waiting", user.c_str(),
+            _queue.size(), _queued_bytes);
+        return "";
+    }
+
+    auto job  = std::make_shared<Job>();
+    job->csv  = std::move(csv);
+    job->done = done;
+    _queued_bytes += job->csv.size();
+
+    job->status.id   = std::to_string(++_last_id);
+    job->status.user = user;
+    _jobs.emplace(job->status.id, job);
+    _queue.push_back(job);
+    if (!_thread.joinable()) {
+        _thread = std::thread(&ImportJobs::worker, this);
+    }
+    _cond.notify_one();
+    log_info("import job %s of user '%s' queued, %zu jobs waiting", job->status.id.c_str(), user.c_str(),
+        _queue.size());
+    return job->status.id;
+}
+
+bool ImportJobs::status(const std::string& id, ImportJobStatus& status) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto                        it = _jobs.find(id);
+    if (it == _jobs.end()) {
+        return false;
+    }
+    const Job& job = *it->second;
+    status.id          = job.status.id;
+    status.user        = job.status.user;
+    status.state       = job.status.state;
+    status.rows_done   = job.status.rows_done;
+    status.rows_failed = job.status.rows_failed;
+    status.error       = job.status.error;
+    if (job.status.state == ImportJobStatus::State::RUNNING) {
+        status.elapsed =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - job.started).count();
+    } else {
+        status.elapsed = job.status.elapsed;
+    }
+    // report is written by worker only before the job is marked as done
+    if (job.status.state == ImportJobStatus::State::DONE) {
+        status.okRows   = job.status.okRows;
+        status.failRows = job.status.failRows;
+    }
+    return true;
+}
+
+void ImportJobs::worker()
+{
+    while (true) {
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _cond.wait(lock, [this] {
+                return _stop || !_queue.empty();
+            });
+            if (_stop) {
+                return;
+            }
+            job = _queue.front();
+            _queue.pop_front();
+            job->status.state = ImportJobStatus::State::RUNNING;
+            job->started      = std::chrono::steady_clock::now();
+        }
+
+        run(*job);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _finished.push_back(job->status.id);
+        while (_finished.size() > KEEP_FINISHED) {
+            _jobs.erase(_finished.front());
+            _finished.pop_front();
+        }
+    }
+}
+
+void ImportJobs::run(Job& job)
+{
+    std::vector<std::pair<db_a_elmnt_t, persist::asset_operation>> okRows;
+    std::map<int, std::string>                                     failRows;
+
+    // touch_fn is called by load_asset_csv on this thread after each processed row, imported or failed
+    size_t processed = 0;
+    auto   touch_fn  = [this, &job, &processed, &failRows]() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_stop) {
+            throw ImportStopped();
+        }
+        ++processed;
+        job.status.rows_failed = failRows.size();
+        job.status.rows_done   = processed > failRows.size() ? processed - failRows.size() : 0;
+    };
+
+    std::string error;
+    try {
+        std::istringstream input{job.csv};
+        load_asset_csv(input, okRows, failRows, touch_fn, job.status.user);
+    } catch (const std::exception& e) {
+        error = e.what();
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _queued_bytes -= job.csv.size();
+    }
+    job.csv.clear();
+    job.csv.shrink_to_fit();
+
+    if (error.empty() && job.done) {
+        try {
+            job.done(okRows);
+        } catch (const std::exception& e) {
+            log_error("import job %s: %s", job.status.id.c_str(), e.what());
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    job.status.elapsed     = std::chrono::duration<double>(std::chrono::steady_clock::now() - job.started).count();
+    job.status.rows_done   = okRows.size();
+    job.status.rows_failed = failRows.size();
+    if (error.empty()) {
+        job.status.okRows   = std::move(okRows);
+        job.status.failRows = std::move(failRows);
+        job.status.state    = ImportJobStatus::State::DONE;
+        log_info("import job %s done in %.1f s, %zu rows imported, %zu rows failed", job.status.id.c_str(),
+            job.status.elapsed, job.status.rows_done, job.status.rows_failed);
+    } else {
+        job.status.error = error;
+        job.status.state = ImportJobStatus::State::FAILED;
+        log_error("import job %s failed: %s", job.status.id.c_str(), error.c_str());
+    }
+}
+
+} // namespace persist
@@ -0,0 +1,131 @@
+/*
+ *
+ * Copyright (C) 2015 - 2020 Eaton
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/// \file   importjobs.h
+/// \brief  Csv import running in background
+///
+/// Uploaded csv is queued as a job and imported by one worker thread, so the http request returns at once and
+/// concurrent imports run one after another. Progress of the running job and the report of finished jobs are
+/// available by job id until the job is evicted by newer ones. Queued jobs hold their csv, so the queue is bounded
+/// both by number of jobs and by their size. Stopped queue (process exit) aborts the running import at next row.
+#pragma once
+
+#include "db/inout.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace persist {
+
+/// Snapshot of an import job
+struct ImportJobStatus
+{
+    enum class State
+    {
+        QUEUED,
+        RUNNING,
+        DONE,
+        FAILED
+    };
+
+    std::string id;
+    std::string user;
+    State       state       = State::QUEUED;
+    size_t      rows_done   = 0; // rows imported without issue so far
+    size_t      rows_failed = 0; // rows rejected or imported with issue so far
+    double      elapsed     = 0; // seconds since the job started
+
+    // final report, filled once state is DONE
+    std::vector<std::pair<db_a_elmnt_t, persist::asset_operation>> okRows;
+    std::map<int, std::string>                                     failRows;
+    // reason of the failure of whole import, filled once state is FAILED
+    std::string error;
+
+    /// return state as a string for REST API
+    static const char* state_str(State state);
+};
+
+/// @class ImportJobs
+class ImportJobs
+{
+public:
+    /// called by worker with rows written by finished import
+    using done_fn = std::function<void(const std::vector<std::pair<db_a_elmnt_t, persist::asset_operation>>&)>;
+
+    /// return the process wide job queue, worker thread is started by the first job
+    static ImportJobs& instance();
+
+    ImportJobs(const ImportJobs&) = delete;
+    ImportJobs& operator=(const ImportJobs&) = delete;
+    ~ImportJobs();
+
+    /// Queues the import of csv content
+    ///
+    /// @param[in] csv  - content of uploaded file
+    /// @param[in] user - user doing the import
+    /// @param[in] done - callback run by worker after successful import (e.g. to send configure)
+    /// @return id of the job, empty if the queue is full and the job was not queued
+    std::string submit(std::string&& csv, const std::string& user, const done_fn& done);
+
+    /// Reads current status of the job, the report is included only for finished jobs
+    ///
+    /// @return false if there is no such job
+    bool status(const std::string& id, ImportJobStatus& status) const;
+
+private:
+    struct Job
+    {
+        ImportJobStatus                       status;
+        std::string                           csv;
+        done_fn                               done;
+        std::chrono::steady_clock::time_point started;
+    };
+
+    ImportJobs() = default;
+
+    void worker();
+    void run(Job& job);
+
+    // finished jobs kept for status queries
+    static const size_t KEEP_FINISHED = 32;
+    // jobs waiting for the worker at most
+    static const size_t MAX_QUEUED = 8;
+    // csv held by waiting and running jobs at most
+    static const size_t MAX_QUEUED_BYTES = 256 * 1024 * 1024;
+
+    mutable std::mutex                          _mutex;
+    std::condition_variable                     _cond;
+    std::deque<std::shared_ptr<Job>>            _queue;    // waiting jobs
+    std::map<std::string, std::shared_ptr<Job>> _jobs;     // all jobs by id
+    std::deque<std::string>                     _finished; // ids of finished jobs, oldest first
+    std::thread                                 _thread;
+    size_t                                      _queued_bytes = 0;
+    size_t                                      _last_id      = 0;
+    bool                                        _stop         = false;
+};
+
+} // namespace persist
@@ -0,0 +1,128 @@
+/*
+ *
+ * Copyright (C) 2015 - 2020 Eaton
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "db/inout/importnames.h"
+#include "db/inout/importplan.h"
+#include "persist/assetcrud.h"
+#include <fty_common.h>
+#include <fty_common_db.h>
+#include <fty_common_macros.h>
+
+namespace persist {
+
+bool ImportNames::load(tntdb::Connection& conn)
+{
+    auto names = select_asset_element_names(conn);
+    if (names.status == 0) {
+        log_error("Cannot read asset names, they will be resolved one by one: %s", names.msg.c_str());
+        return false;
+    }
+
+    _by_name.clear();
+    _by_ext_name.clear();
+    _by_id.clear();
+    _by_name.reserve(names.item.size());
+    _by_ext_name.reserve(names.item.size());
+    _by_id.reserve(names.item.size());
+    for (const auto& name : names.item) {
+        update(name.id, name.name, name.ext_name);
+    }
+    _loaded = true;
+    log_debug("%zu asset names loaded", _by_id.size());
+    return true;
+}
+
+bool ImportNames::exists_key(const std::string& key) const
+{
+    return _by_name.count(key) != 0 || _by_ext_name.count(key) != 0;
+}
+
+int ImportNames::extname_to_asset_name(const std::string& ext_name, std::string& name) const
+{
+    if (!_loaded) {
+        return DBAssets::extname_to_asset_name(ext_name, name);
+    }
+    auto it = _by_ext_name.find(ImportPlan::key(ext_name));
+    if (it == _by_ext_name.end()) {
+        return -1;
+    }
+    name = _by_id.at(it->second).first;
+    return 0;
+}
+
+int64_t ImportNames::name_to_asset_id(const std::string& name) const
+{
+    if (!_loaded) {
+        return DBAssets::name_to_asset_id(name);
+    }
+    auto it = _by_name.find(ImportPlan::key(name));
+    return it == _by_name.end() ? -1 : int64_t(it->second);
+}
+
+db_reply<a_elmnt_id_t> ImportNames::select_id_by_name(tntdb::Connection& conn, const std::string& name) const
+{
+    db_reply<a_elmnt_id_t> ret = db_reply_new(a_elmnt_id_t(0));
+    if (!_loaded) {
+        auto element   = select_asset_element_by_name(conn, name.c_str());
+        ret.status     = element.status;
+        ret.errtype    = element.errtype;
+        ret.errsubtype = element.errsubtype;
+        ret.msg        = element.msg;
+        ret.item       = element.item.id;
+        return ret;
+    }
+
+    // internal name has the precedence like in DB lookup
+    std::string key   = ImportPlan::key(name);
+    auto        found = _by_name.find(key);
+    if (found != _by_name.end()) {
+        ret.status = 1;
+        ret.item   = found->second;
+        return ret;
+    }
+    found = _by_ext_name.find(key);
+    if (found != _by_ext_name.end()) {
+        ret.status = 1;
+        ret.item   = found->second;
+        return ret;
+    }
+
+    ret.status     = 0;
+    ret.errtype    = DB_ERR;
+    ret.errsubtype = DB_ERROR_NOTFOUND;
+    ret.msg        = TRANSLATE_ME("element with specified name was not found");
+    return ret;
+}
+
+void ImportNames::update(a_elmnt_id_t id, const std::string& name, const std::string& ext_name)
+{
+    auto it = _by_id.find(id);
+    if (it != _by_id.end()) {
+        _by_name.erase(ImportPlan::key(it->second.first));
+        _by_ext_name.erase(ImportPlan::key(it->second.second));
+    }
+    _by_id[id] = std::make_pair(name, ext_name);
+    _by_name[ImportPlan::key(name)] = id;
+    if (!ext_name.empty()) {
+        _by_ext_name[ImportPlan::key(ext_name)] = id;
+    }
+}
+
+} // namespace persist
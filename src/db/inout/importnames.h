@@ -0,0 +1,83 @@
+/*
+ *
+ * Copyright (C) 2015 - 2020 Eaton
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/// \file   importnames.h
+/// \brief  Names of assets resolved during csv import
+///
+/// Csv refers to assets by their external or internal names. Instead of one query per name and row, names of all
+/// assets are read once when the import starts and assets written by the import are added as they are created.
+/// When the names can't be read, every lookup goes to DB as before.
+#pragma once
+
+#include "db/dbhelpers.h"
+#include "dbtypes.h"
+#include <string>
+#include <tntdb/connect.h>
+#include <unordered_map>
+#include <utility>
+
+namespace persist {
+
+/// @class ImportNames
+class ImportNames
+{
+public:
+    /// Creates an empty dictionary, all lookups go to DB until load() succeeds
+    ImportNames(void)
+        : _loaded{false}
+        , _by_name{}
+        , _by_ext_name{}
+        , _by_id{} {};
+
+    /// Reads names of all assets from DB
+    ///
+    /// @return false if names could not be read
+    bool load(tntdb::Connection& conn);
+
+    /// return if the names are held in memory
+    bool loaded() const
+    {
+        return _loaded;
+    }
+
+    /// return if asset of given internal or external name exists, name must be normalized by ImportPlan::key
+    bool exists_key(const std::string& key) const;
+
+    /// internal name of asset with given external name, return codes are the same as of
+    /// DBAssets::extname_to_asset_name
+    int extname_to_asset_name(const std::string& ext_name, std::string& name) const;
+
+    /// return id of asset with given internal name or -1 like DBAssets::name_to_asset_id
+    int64_t name_to_asset_id(const std::string& name) const;
+
+    /// find asset by internal name or external name like select_asset_element_by_name, only id is resolved
+    db_reply<a_elmnt_id_t> select_id_by_name(tntdb::Connection& conn, const std::string& name) const;
+
+    /// register asset written by the import, replaces the names it had before
+    void update(a_elmnt_id_t id, const std::string& name, const std::string& ext_name);
+
+private:
+    bool                                                                   _loaded;
+    std::unordered_map<std::string, a_elmnt_id_t>                          _by_name;     // normalized internal name
+    std::unordered_map<std::string, a_elmnt_id_t>                          _by_ext_name; // normalized external name
+    std::unordered_map<a_elmnt_id_t, std::pair<std::string, std::string>> _by_id;       // internal, external name
+};
+
+} // namespace persist
@@ -0,0 +1,173 @@
+/*
+ *
+ * Copyright (C) 2015 - 2020 Eaton
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "db/inout/importplan.h"
+#include <algorithm>
+#include <fty_common.h>
+#include <fty_common_macros.h>
+#include <queue>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace persist {
+
+using shared::ColumnHandle;
+using shared::CsvMap;
+
+// rows with lower rank are imported first when there is no reference between them
+static int s_type_rank(const std::string& type)
+{
+    static const std::map<std::string, int> RANKS = {
+        {"datacenter", 0}, {"room", 1}, {"row", 2}, {"rack", 3}, {"group", 4}};
+    auto it = RANKS.find(type);
+    return it == RANKS.end() ? 5 : it->second;
+}
+
+bool ImportPlan::is_reference(const std::string& title)
+{
+    return title == "location" || title == "logical_asset" || title.compare(0, 13, "power_source.") == 0 ||
+           title.compare(0, 6, "group.") == 0;
+}
+
+std::string ImportPlan::key(std::string_view name)
+{
+    std::string ret{name};
+    std::transform(ret.begin(), ret.end(), ret.begin(), ::tolower);
+    return ret;
+}
+
+// returns the cell or empty string on short rows, process_row reports those
+static std::string_view s_cell(const CsvMap& cm, size_t row_i, ColumnHandle column)
+{
+    if (!column) {
+        return {};
+    }
+    try {
+        return cm.cell(row_i, column);
+    } catch (const std::out_of_range&) {
+        return {};
+    }
+}
+
+ImportPlan::ImportPlan(const CsvMap& cm, const exists_fn& exists)
+    : _order{}
+    , _depends_on{}
+    , _rejected{}
+{
+    const size_t rows = cm.rows();
+    _depends_on.resize(rows);
+    if (rows < 2) {
+        return;
+    }
+
+    // assets defined by the csv, both by external and internal name
+    std::unordered_map<std::string, size_t> defined;
+    const ColumnHandle                      name_col = cm.column("name");
+    const ColumnHandle                      id_col   = cm.column("id");
+    for (size_t row_i = 1; row_i != rows; ++row_i) {
+        for (const auto& column : {name_col, id_col}) {
+            auto name = s_cell(cm, row_i, column);
+            if (!name.empty()) {
+                defined.emplace(key(name), row_i);
+            }
+        }
+    }
+
+    std::vector<ColumnHandle> references;
+    for (size_t col_i = 0; col_i != cm.cols(); ++col_i) {
+        if (is_reference(cm.titles()[col_i])) {
+            references.push_back(cm.column_at(col_i));
+        }
+    }
+
+    std::vector<size_t>              pending(rows, 0); // number of not yet ordered dependencies
+    std::vector<std::vector<size_t>> dependents(rows);
+    for (size_t row_i = 1; row_i != rows; ++row_i) {
+        for (const auto& column : references) {
+            auto name = s_cell(cm, row_i, column);
+            if (name.empty()) {
+                continue;
+            }
+            auto it = defined.find(key(name));
+            if (it == defined.end()) {
+                if (!exists(key(name)) && _rejected.count(row_i) == 0) {
+                    _rejected.emplace(row_i,
+                        TRANSLATE_ME("Element '%s' referred in column '%s' does not exist", std::string{name}.c_str(),
+                            cm.title(column).c_str()));
+                }
+                continue;
+            }
+            size_t dep = it->second;
+            // power source being myself is ignored by the import
+            if (dep == row_i) {
+                continue;
+            }
+            auto& deps = _depends_on[row_i];
+            if (std::find(deps.begin(), deps.end(), dep) == deps.end()) {
+                deps.push_back(dep);
+                dependents[dep].push_back(row_i);
+                pending[row_i]++;
+            }
+        }
+    }
+
+    // Kahn's algorithm, ready rows are taken by type rank and then in order of the file
+    const ColumnHandle type_col = cm.column("type");
+    auto               rank     = [&cm, &type_col](size_t row_i) {
+        try {
+            return s_type_rank(cm.get_strip(row_i, type_col));
+        } catch (const std::out_of_range&) {
+            return s_type_rank("");
+        }
+    };
+    using ready_t = std::pair<int, size_t>;
+    std::priority_queue<ready_t, std::vector<ready_t>, std::greater<ready_t>> ready;
+    for (size_t row_i = 1; row_i != rows; ++row_i) {
+        if (pending[row_i] == 0) {
+            ready.emplace(rank(row_i), row_i);
+        }
+    }
+
+    std::vector<bool> visited(rows, false);
+    _order.reserve(rows - 1);
+    while (!ready.empty()) {
+        size_t row_i = ready.top().second;
+        ready.pop();
+        visited[row_i] = true;
+        // rejected rows still release their dependents, those fail on the missing dependency later
+        if (_rejected.count(row_i) == 0) {
+            _order.push_back(row_i);
+        }
+        for (size_t next : dependents[row_i]) {
+            if (--pending[next] == 0) {
+                ready.emplace(rank(next), next);
+            }
+        }
+    }
+
+    for (size_t row_i = 1; row_i != rows; ++row_i) {
+        if (!visited[row_i]) {
+            log_debug("row %zu is part of or depends on a reference cycle", row_i);
+            _rejected[row_i] = TRANSLATE_ME("Cyclic reference, location or power source refers back to this asset");
+        }
+    }
+}
+
+} // namespace persist
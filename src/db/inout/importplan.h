@@ -0,0 +1,83 @@
+/*
+ *
+ * Copyright (C) 2015 - 2020 Eaton
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/// \file   importplan.h
+/// \brief  Order of rows for csv import
+///
+/// Rows refer to other assets by name in columns location, logical_asset, power_source.N and group.N. When the
+/// referred asset is defined in the same file, its row must be imported first. ImportPlan builds the graph of
+/// those references before anything is written to DB, orders rows topologically (datacenter, room, row, rack and
+/// the rest when there is no other constraint) and rejects rows which can never be imported.
+#pragma once
+
+#include "shared/csv.h"
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace persist {
+
+/// @class ImportPlan
+class ImportPlan
+{
+public:
+    /// callback telling if the asset of given name (internal or external, normalized by key()) exists in DB already
+    using exists_fn = std::function<bool(const std::string&)>;
+
+    /// return name normalized for comparison, names are case insensitive like in DB
+    static std::string key(std::string_view name);
+
+    /// return if the column of given normalized title contains name of another asset
+    static bool is_reference(const std::string& title);
+
+    /// Creates the plan for data rows of the csv map
+    ///
+    /// Rows in cycle and rows referring to asset which is neither in csv nor in DB are rejected.
+    /// @param[in] cm     - already parsed csv file
+    /// @param[in] exists - callback resolving names not defined by the csv
+    ImportPlan(const shared::CsvMap& cm, const exists_fn& exists);
+
+    /// return rows to be imported in this order
+    const std::vector<size_t>& order() const
+    {
+        return _order;
+    }
+
+    /// return rows defined in csv, which the row refers to
+    const std::vector<size_t>& dependencies(size_t row_i) const
+    {
+        return _depends_on.at(row_i);
+    }
+
+    /// return rejected rows with the reason
+    const std::map<size_t, std::string>& rejected() const
+    {
+        return _rejected;
+    }
+
+private:
+    std::vector<size_t>              _order;
+    std::vector<std::vector<size_t>> _depends_on; // indexed by row
+    std::map<size_t, std::string>    _rejected;
+};
+
+} // namespace persist
@@ -0,0 +1,245 @@
+/*
+ *
+ * Copyright (C) 2015 - 2020 Eaton
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "db/inout/licensinglimitations.h"
+#include <cassert>
+#include <fty_common.h>
+#include <fty_common_macros.h>
+#include <fty_common_mlm_pool.h>
+#include <fty_common_mlm_utils.h>
+#include <fty_common_rest.h>
+#include <fty_proto.h>
+#include <malamute.h>
+
+namespace persist {
+
+constexpr std::chrono::seconds LicensingLimitations::TTL;
+
+// name of the asset licensing limitations are announced for
+static const char* LIMITATIONS_ASSET = "rackcontroller-0";
+
+/*
+ * \brief Sets the limitation the metric carries, if any
+ */
+static void s_apply_metric(fty_proto_t* metric, LIMITATIONS_STRUCT& limitations)
+{
+    if (!streq(fty_proto_name(metric), LIMITATIONS_ASSET)) {
+        return;
+    }
+    if (streq(fty_proto_type(metric), "power_nodes.max_active")) {
+        limitations.max_active_power_devices = atoi(fty_proto_value(metric));
+        log_debug("limitations.max_active_power_device set to %i", limitations.max_active_power_devices);
+    } else if (streq(fty_proto_type(metric), "configurability.global")) {
+        limitations.global_configurability = atoi(fty_proto_value(metric));
+        log_debug("limitations.global_configurability set to %i", limitations.global_configurability);
+    }
+}
+
+LicensingLimitations& LicensingLimitations::instance()
+{
+    static LicensingLimitations limitations;
+    return limitations;
+}
+
+LicensingLimitations::LicensingLimitations()
+    : _limitations{-1, 0}
+{
+    _thread = std::thread(&LicensingLimitations::listener, this);
+}
+
+LicensingLimitations::~LicensingLimitations()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+LIMITATIONS_STRUCT LicensingLimitations::get()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_valid) {
+            bool expired = _expired || std::chrono::steady_clock::now() - _updated >= TTL;
+            // without listener there is nobody to re-query in background
+            if (!expired || _listening) {
+                return _limitations;
+            }
+        }
+    }
+
+    try {
+        return refresh();
+    } catch (const std::invalid_argument& e) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_valid) {
+            throw;
+        }
+        log_warning("licensing limitations not refreshed, using cached ones: %s", e.what());
+        return _limitations;
+    }
+}
+
+LIMITATIONS_STRUCT LicensingLimitations::refresh()
+{
+    LIMITATIONS_STRUCT limitations = query();
+    store(limitations);
+    return limitations;
+}
+
+void LicensingLimitations::invalidate()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _expired = true;
+}
+
+void LicensingLimitations::store(const LIMITATIONS_STRUCT& limitations)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _limitations = limitations;
+    _updated     = std::chrono::steady_clock::now();
+    _valid       = true;
+    _expired     = false;
+}
+
+LIMITATIONS_STRUCT LicensingLimitations::query()
+{
+    // default values
+    LIMITATIONS_STRUCT limitations{-1, 0};
+    // query values
+    auto    client_ptr = mlm_pool.get();
+    zmsg_t* request    = zmsg_new();
+    zmsg_addstr(request, "LIMITATION_QUERY");
+    zuuid_t*    zuuid     = zuuid_new();
+    const char* zuuid_str = zuuid_str_canonical(zuuid);
+    zmsg_addstr(request, zuuid_str);
+    zmsg_addstr(request, "*");
+    zmsg_addstr(request, "*");
+    int rv = client_ptr->sendto("etn-licensing", "LIMITATION_QUERY", 1000, &request);
+    if (rv == -1) {
+        zuuid_destroy(&zuuid);
+        zmsg_destroy(&request);
+        log_fatal("Cannot send message to etn-licensing");
+        std::string err = TRANSLATE_ME("mlm_client_sendto failed.");
+        bios_throw("internal-error", err.c_str());
+    }
+
+    zmsg_t* response = client_ptr->recv(zuuid_str, 30);
+    zuuid_destroy(&zuuid);
+    if (!response) {
+        log_fatal("client->recv (timeout = '30') returned NULL for LIMITATION_QUERY");
+        std::string err = TRANSLATE_ME("client->recv () returned NULL");
+        bios_throw("internal-error", err.c_str());
+    }
+    char* reply  = zmsg_popstr(response);
+    char* status = zmsg_popstr(response);
+    if (streq(status, "OK") && streq(reply, "REPLY")) {
+        zmsg_t* submsg = zmsg_popmsg(response);
+        while (submsg) {
+            fty_proto_t* submetric = fty_proto_decode(&submsg);
+            assert(fty_proto_id(submetric) == FTY_PROTO_METRIC);
+            s_apply_metric(submetric, limitations);
+            fty_proto_destroy(&submetric);
+            submsg = zmsg_popmsg(response);
+        }
+    }
+    zstr_free(&reply);
+    zstr_free(&status);
+    zmsg_destroy(&response);
+    return limitations;
+}
+
+void LicensingLimitations::listener()
+{
+    mlm_client_t* client      = mlm_client_new();
+    std::string   client_name = utils::generate_mlm_client_id("web.licensing");
+    if (!client || mlm_client_connect(client, MLM_ENDPOINT, 1000, client_name.c_str()) == -1 ||
+        mlm_client_set_consumer(client, FTY_PROTO_STREAM_LICENSING_ANNOUNCEMENTS, ".*") == -1) {
+        log_error("cannot listen to licensing announcements, limitations are re-queried on demand");
+        mlm_client_destroy(&client);
+        return;
+    }
+    zpoller_t* poller = zpoller_new(mlm_client_msgpipe(client), NULL);
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _listening = true;
+    }
+
+    while (true) {
+        void* which = zpoller_wait(poller, 1000);
+        bool  requery;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_stop) {
+                break;
+            }
+            requery = !_valid || _expired || std::chrono::steady_clock::now() - _updated >= TTL;
+        }
+
+        if (which) {
+            zmsg_t* msg = mlm_client_recv(client);
+            if (msg && fty_proto_is(msg)) {
+                fty_proto_t* metric = fty_proto_decode(&msg);
+                if (metric && fty_proto_id(metric) == FTY_PROTO_METRIC) {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    // announcement changes one limitation, the rest must be known already
+                    if (_valid) {
+                        s_apply_metric(metric, _limitations);
+                    } else {
+                        requery = true;
+                    }
+                }
+                fty_proto_destroy(&metric);
+            }
+            zmsg_destroy(&msg);
+        } else if (zpoller_terminated(poller)) {
+            break;
+        }
+
+        if (requery) {
+            try {
+                store(query());
+            } catch (const std::exception& e) {
+                log_warning("licensing limitations not refreshed: %s", e.what());
+                // try again after TTL, cached ones are used meanwhile
+                std::lock_guard<std::mutex> lock(_mutex);
+                _updated = std::chrono::steady_clock::now();
+                _expired = false;
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _listening = false;
+    }
+    zpoller_destroy(&poller);
+    mlm_client_destroy(&client);
+}
+
+void get_licensing_limitation(LIMITATIONS_STRUCT& limitations)
+{
+    limitations = LicensingLimitations::instance().get();
+}
+
+} // namespace persist
@@ -0,0 +1,90 @@
+/*
+ *
+ * Copyright (C) 2015 - 2020 Eaton
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/// \file   licensinglimitations.h
+/// \brief  Cached licensing limitations
+///
+/// Limitations are queried from the licensing agent once and kept in the process. A listener thread follows
+/// licensing announcements and updates them as they change, and queries the agent again once they are older than
+/// TTL, so creating an asset waits for the broker only if nothing was read yet.
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+namespace persist {
+
+typedef struct _LIMITATIONS_STRUCT
+{
+    int max_active_power_devices;
+    int global_configurability;
+} LIMITATIONS_STRUCT;
+
+/// @class LicensingLimitations
+class LicensingLimitations
+{
+public:
+    /// cached limitations are queried again once older than this
+    static constexpr std::chrono::seconds TTL{60};
+
+    /// return the process wide cache, listener thread is started by the first use
+    static LicensingLimitations& instance();
+
+    LicensingLimitations(const LicensingLimitations&) = delete;
+    LicensingLimitations& operator=(const LicensingLimitations&) = delete;
+    ~LicensingLimitations();
+
+    /// Returns cached limitations, expired ones are returned as well and re-queried in background
+    ///
+    /// @throws std::invalid_argument if nothing was read yet and the licensing agent does not reply
+    LIMITATIONS_STRUCT get();
+
+    /// Queries the licensing agent now and replaces cached limitations
+    ///
+    /// @throws std::invalid_argument if the licensing agent does not reply
+    LIMITATIONS_STRUCT refresh();
+
+    /// Marks cached limitations as expired, they are re-queried in background without blocking the caller
+    void invalidate();
+
+private:
+    LicensingLimitations();
+
+    /// query the licensing agent over mlm pool
+    static LIMITATIONS_STRUCT query();
+
+    void listener();
+    void store(const LIMITATIONS_STRUCT& limitations);
+
+    mutable std::mutex                    _mutex;
+    LIMITATIONS_STRUCT                    _limitations;
+    std::chrono::steady_clock::time_point _updated;
+    bool                                  _valid     = false; // something was read already
+    bool                                  _expired   = false; // re-query requested
+    bool                                  _listening = false; // listener thread is connected
+    bool                                  _stop      = false;
+    std::thread                           _thread;
+};
+
+/// Returns cached licensing limitations, see LicensingLimitations::get
+void get_licensing_limitation(LIMITATIONS_STRUCT& limitations);
+
+} // namespace persist
@@ -314,6 +314,158 @@ db_reply <db_a_elmnt_t>
     }
 }
 
+db_reply <std::vector<db_a_elmnt_name_t>>
+    select_asset_element_names
+        (tntdb::Connection &conn)
+{
+    LOG_START;
+
+    std::vector<db_a_elmnt_name_t> item{};
+    db_reply <std::vector<db_a_elmnt_name_t>> ret = db_reply_new(item);
+
+    try {
+        tntdb::Statement st = conn.prepare(
+            " SELECT"
+            "   v.id, v.name, ext.value"
+            " FROM"
+            "   v_bios_asset_element AS v"
+            " LEFT JOIN"
+            "   v_bios_asset_ext_attributes AS ext"
+            " ON"
+            "   ext.id_asset_element = v.id AND ext.keytag = 'name'"
+        );
+
+        tntdb::Result result = st.select();
+        ret.item.reserve(result.size());
+        for ( auto &row: result )
+        {
+            db_a_elmnt_name_t name{0, "", ""};
+            row[0].get(name.id);
+            row[1].get(name.name);
+            row[2].get(name.ext_name);  // stays empty on NULL
+            ret.item.push_back(std::move(name));
+        }
+        ret.status = 1;
+        LOG_END;
+        return ret;
+    }
+    catch (const std::exception &e) {
+        ret.status        = 0;
+        ret.errtype       = DB_ERR;
+        ret.errsubtype    = DB_ERROR_INTERNAL;
+        ret.msg           = JSONIFY(e.what());
+        ret.item.clear();
+        LOG_END_ABNORMAL(e);
+        return ret;
+    }
+}
+
+db_reply <db_a_elmnt_state_t>
+    select_asset_element_state
+        (tntdb::Connection &conn,
+         a_elmnt_id_t element_id)
+{
+    LOG_START;
+    log_debug ("element_id = %" PRIu32, element_id);
+
+    db_a_elmnt_state_t item{};
+    db_reply <db_a_elmnt_state_t> ret = db_reply_new(item);
+
+    try {
+        tntdb::Statement st = conn.prepareCached(
+            " SELECT"
+            "   v.name, v.id_parent, v.status, v.priority, v.asset_tag,"
+            "   v.id_type, v.id_subtype"
+            " FROM"
+            "   t_bios_asset_element v"
+            " WHERE v.id_asset_element = :id"
+        );
+        tntdb::Row row = st.set("id", element_id).selectRow();
+
+        ret.item.element.id = element_id;
+        row[0].get(ret.item.element.name);
+        row[1].get(ret.item.element.parent_id);  // stays 0 on NULL
+        row[2].get(ret.item.element.status);
+        row[3].get(ret.item.element.priority);
+        row[4].get(ret.item.element.asset_tag);
+        row[5].get(ret.item.element.type_id);
+        row[6].get(ret.item.element.subtype_id);
+
+        st = conn.prepareCached(
+            " SELECT"
+            "   v.keytag, v.value, v.read_only"
+            " FROM"
+            "   t_bios_asset_ext_attributes v"
+            " WHERE v.id_asset_element = :id"
+        );
+        for ( auto &ext_row: st.set("id", element_id).select() )
+        {
+            std::string keytag, value;
+            int read_only = 0;
+            ext_row[0].get(keytag);
+            ext_row[1].get(value);
+            ext_row[2].get(read_only);
+            if ( read_only )
+                ret.item.ext_ro.emplace(keytag, value);
+            else
+                ret.item.element.ext.emplace(keytag, value);
+        }
+
+        st = conn.prepareCached(
+            " SELECT"
+            "   v.id_asset_group"
+            " FROM"
+            "   t_bios_asset_group_relation v"
+            " WHERE v.id_asset_element = :id"
+        );
+        for ( auto &group_row: st.set("id", element_id).select() )
+        {
+            a_elmnt_id_t group_id = 0;
+            group_row[0].get(group_id);
+            ret.item.groups.insert(group_id);
+        }
+
+        st = conn.prepareCached(
+            " SELECT"
+            "   v.id_asset_device_src, v.src_out, v.dest_in, v.id_asset_link_type"
+            " FROM"
+            "   t_bios_asset_link v"
+            " WHERE v.id_asset_device_dest = :id"
+        );
+        for ( auto &link_row: st.set("id", element_id).select() )
+        {
+            a_elmnt_id_t src = 0;
+            std::string src_out, dest_in;  // stay empty on NULL
+            link_row[0].get(src);
+            link_row[1].get(src_out);
+            link_row[2].get(dest_in);
+            a_lnk_tp_id_t type = a_lnk_tp_id_t(link_row[3].getUnsigned());
+            ret.item.links.emplace(src, src_out, dest_in, type);
+        }
+
+        ret.status = 1;
+        LOG_END;
+        return ret;
+    }
+    catch (const tntdb::NotFound &e) {
+        ret.status        = 0;
+        ret.errtype       = DB_ERR;
+        ret.errsubtype    = DB_ERROR_NOTFOUND;
+        ret.msg           = TRANSLATE_ME("element with specified id was not found");
+        LOG_END;
+        return ret;
+    }
+    catch (const std::exception &e) {
+        ret.status        = 0;
+        ret.errtype       = DB_ERR;
+        ret.errsubtype    = DB_ERROR_INTERNAL;
+        ret.msg           = JSONIFY(e.what());
+        ret.item          = db_a_elmnt_state_t{};
+        LOG_END_ABNORMAL(e);
+        return ret;
+    }
+}
+
 db_reply <std::vector<db_a_elmnt_t>>
     select_asset_elements_by_type
         (tntdb::Connection &conn,
@@ -27,6 +27,7 @@
 #include "dbtypes.h"
 #include <fty_common_db_asset.h>
 #include <tntdb/connect.h>
+#include <tuple>
 
 // ===============================================================
 // Helper functions for direct interacting with database
@@ -36,6 +37,39 @@ std::set<a_elmnt_id_t> select_asset_group_elements(tntdb::Connection& conn, a_el
 zlist_t* select_asset_device_links_all(tntdb::Connection& conn, a_elmnt_id_t device_id, a_lnk_tp_id_t link_type_id);
 db_reply<db_a_elmnt_t> select_asset_element_by_name(tntdb::Connection& conn, const char* element_name);
 
+/// Internal and external name of an asset element
+struct db_a_elmnt_name_t
+{
+    a_elmnt_id_t id;
+    std::string  name;
+    std::string  ext_name; // empty if not set
+};
+
+/// Reads ids, internal and external names of all asset elements in one query
+///
+/// @param[in] conn - the connection to database.
+/// @return a database reply where item is a list of names. In case of any erorrs item would be empty.
+db_reply<std::vector<db_a_elmnt_name_t>> select_asset_element_names(tntdb::Connection& conn);
+
+/// Power link leading to an asset: source, src_out, dest_in and link type, NULL outlets are empty
+typedef std::tuple<a_elmnt_id_t, std::string, std::string, a_lnk_tp_id_t> db_a_link_key_t;
+
+/// Everything an update of asset rewrites: the element, ext attributes, groups and links leading to it
+struct db_a_elmnt_state_t
+{
+    db_a_elmnt_t                       element; // ext contains read-write ext attributes only
+    std::map<std::string, std::string> ext_ro;  // read only ext attributes
+    std::set<a_elmnt_id_t>             groups;
+    std::set<db_a_link_key_t>          links;
+};
+
+/// Reads current state of the asset element in four queries
+///
+/// @param[in] conn       - the connection to database.
+/// @param[in] element_id - id of the asset element
+/// @return a database reply where item is the state. In case of any erorrs item would be empty.
+db_reply<db_a_elmnt_state_t> select_asset_element_state(tntdb::Connection& conn, a_elmnt_id_t element_id);
+
 // dictionaries
 
 /// Reads from database all available element types.
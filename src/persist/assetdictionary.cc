@@ -0,0 +1,83 @@
+/*
+ *
+ * Copyright (C) 2015 - 2020 Eaton
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "persist/assetdictionary.h"
+#include "persist/assetcrud.h"
+#include <atomic>
+#include <fty_common.h>
+#include <fty_common_db_dbpath.h>
+
+namespace persist {
+
+// current snapshot, accessed only by std::atomic_load/std::atomic_store
+static std::shared_ptr<const AssetDictionary::Snapshot> s_snapshot;
+
+std::shared_ptr<const AssetDictionary::Snapshot> AssetDictionary::get()
+{
+    auto snapshot = std::atomic_load(&s_snapshot);
+    if (!snapshot) {
+        refresh();
+        snapshot = std::atomic_load(&s_snapshot);
+    }
+    if (!snapshot) {
+        static const auto empty = std::make_shared<const Snapshot>();
+        return empty;
+    }
+    return snapshot;
+}
+
+bool AssetDictionary::loaded()
+{
+    return std::atomic_load(&s_snapshot) != nullptr;
+}
+
+bool AssetDictionary::refresh(tntdb::Connection& conn)
+{
+    auto types    = get_dictionary_element_type(conn);
+    auto subtypes = get_dictionary_device_type(conn);
+    // in case of any error, it would be empty
+    if (types.item.empty() || subtypes.item.empty()) {
+        log_error("cannot read asset type dictionaries: %s",
+            types.item.empty() ? types.msg.c_str() : subtypes.msg.c_str());
+        return false;
+    }
+
+    auto snapshot      = std::make_shared<Snapshot>();
+    snapshot->types    = std::move(types.item);
+    snapshot->subtypes = std::move(subtypes.item);
+    log_debug("asset type dictionaries loaded, %zu types, %zu subtypes", snapshot->types.size(),
+        snapshot->subtypes.size());
+
+    std::atomic_store(&s_snapshot, std::shared_ptr<const Snapshot>(std::move(snapshot)));
+    return true;
+}
+
+bool AssetDictionary::refresh()
+{
+    try {
+        tntdb::Connection conn = tntdb::connect(DBConn::url);
+        return refresh(conn);
+    } catch (const std::exception& e) {
+        log_error("cannot read asset type dictionaries: %s", e.what());
+        return false;
+    }
+}
+
+} // namespace persist
@@ -0,0 +1,65 @@
+/*
+ *
+ * Copyright (C) 2015 - 2020 Eaton
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/// @file   assetdictionary.h
+/// @brief  Process wide cache of asset element and device types
+///
+/// Used by the asset import to map type names to ids, lookups by id stay on the static persist::typeid_to_type.
+/// Types are read from DB once the database is ready and kept as an immutable snapshot. Readers take the current
+/// snapshot without locking, refresh builds a new one and swaps it in, so readers holding the old one are not
+/// affected.
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <tntdb/connect.h>
+
+namespace persist {
+
+/// @class AssetDictionary
+class AssetDictionary
+{
+public:
+    struct Snapshot
+    {
+        std::map<std::string, int> types;    // element type name -> id
+        std::map<std::string, int> subtypes; // device type name -> id
+    };
+
+    /// Returns current snapshot, reads it from DB on first use
+    ///
+    /// @return snapshot, maps are empty if the dictionaries cannot be read
+    static std::shared_ptr<const Snapshot> get();
+
+    /// return if the dictionaries were read from DB already
+    static bool loaded();
+
+    /// Reads the dictionaries from DB and replaces the current snapshot
+    ///
+    /// @param[in] conn - the connection to database.
+    /// @return false if the dictionaries cannot be read, current snapshot is kept then
+    static bool refresh(tntdb::Connection& conn);
+
+    /// Same as above, connects to DB itself
+    static bool refresh();
+};
+
+} // namespace persist
@@ -0,0 +1,358 @@
+/*
+ *
+ * Copyright (C) 2015 - 2020 Eaton
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "persist/assetnames.h"
+#include "shared/sql_in.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <fty_common.h>
+#include <fty_common_db_asset.h>
+#include <fty_common_db_dbpath.h>
+#include <iterator>
+#include <mutex>
+#include <tntdb/result.h>
+#include <tntdb/row.h>
+#include <tntdb/statement.h>
+
+namespace persist {
+
+// current snapshot, accessed only by std::atomic_load/std::atomic_store
+static std::shared_ptr<const AssetNames::Snapshot> s_snapshot;
+
+// writers copy the snapshot, they must not lose each other's changes
+static std::mutex s_write_mutex;
+
+// announcements of assets changed elsewhere are passed to reload()
+static std::atomic<bool> s_following{false};
+
+static const char* NAMES_SELECT =
+    " SELECT"
+    "   v.id, v.name, ext.value"
+    " FROM"
+    "   v_bios_asset_element AS v"
+    " LEFT JOIN"
+    "   v_bios_asset_ext_attributes AS ext"
+    " ON"
+    "   ext.id_asset_element = v.id AND ext.keytag = 'name'"
+    " WHERE ";
+
+/*
+ * \brief Lookup key of a name, DB compares names case insensitive
+ */
+static std::string s_key(const std::string& name)
+{
+    std::string key{name};
+    std::transform(key.begin(), key.end(), key.begin(), [](unsigned char ch) {
+        return char(std::tolower(ch));
+    });
+    return key;
+}
+
+/*
+ * \brief Removes the asset and the names which point to it
+ */
+static void s_remove(AssetNames::Snapshot& snapshot, a_elmnt_id_t id)
+{
+    auto it = snapshot.by_id.find(id);
+    if (it == snapshot.by_id.end()) {
+        return;
+    }
+    auto name = snapshot.by_name.find(s_key(it->second.first));
+    if (name != snapshot.by_name.end() && name->second == id) {
+        snapshot.by_name.erase(name);
+    }
+    if (!it->second.second.empty()) {
+        auto ext_name = snapshot.by_ext_name.find(s_key(it->second.second));
+        if (ext_name != snapshot.by_ext_name.end() && ext_name->second == id) {
+            snapshot.by_ext_name.erase(ext_name);
+        }
+    }
+    snapshot.by_id.erase(it);
+}
+
+static void s_add(AssetNames::Snapshot& snapshot, const db_a_elmnt_name_t& name)
+{
+    s_remove(snapshot, name.id);
+    snapshot.by_id[name.id]            = {name.name, name.ext_name};
+    snapshot.by_name[s_key(name.name)] = name.id;
+    if (!name.ext_name.empty()) {
+        snapshot.by_ext_name[s_key(name.ext_name)] = name.id;
+    }
+}
+
+/*
+ * \brief Reads names of the assets the condition selects, values are bound to its placeholders :n0, :n1, ...
+ */
+static std::vector<db_a_elmnt_name_t> s_select(
+    tntdb::Connection& conn, const std::string& condition, const std::vector<std::string>& values)
+{
+    tntdb::Statement st = conn.prepare(NAMES_SELECT + condition);
+    shared::sql_in_bind(st, values);
+
+    std::vector<db_a_elmnt_name_t> names;
+    for (const auto& row : st.select()) {
+        db_a_elmnt_name_t name{0, "", ""};
+        row[0].get(name.id);
+        row[1].get(name.name);
+        row[2].get(name.ext_name); // stays empty on NULL
+        names.push_back(std::move(name));
+    }
+    return names;
+}
+
+/*
+ * \brief Drops the snapshot after a failed reload, it can't be trusted anymore and next use reads everything again
+ */
+static void s_drop()
+{
+    std::lock_guard<std::mutex> lock(s_write_mutex);
+    std::atomic_store(&s_snapshot, std::shared_ptr<const AssetNames::Snapshot>());
+}
+
+/*
+ * \brief Applies the change to a copy of the current snapshot and swaps it in, nothing is done before first load
+ */
+template <typename Change>
+static void s_modify(Change&& change)
+{
+    std::lock_guard<std::mutex> lock(s_write_mutex);
+    auto                        current = std::atomic_load(&s_snapshot);
+    if (!current) {
+        return;
+    }
+    auto snapshot = std::make_shared<AssetNames::Snapshot>(*current);
+    change(*snapshot);
+    std::atomic_store(&s_snapshot, std::shared_ptr<const AssetNames::Snapshot>(std::move(snapshot)));
+}
+
+std::shared_ptr<const AssetNames::Snapshot> AssetNames::get()
+{
+    static const auto empty = std::make_shared<const Snapshot>();
+    // names changed elsewhere are not seen, lookups go to DB
+    if (!s_following) {
+        return empty;
+    }
+    auto snapshot = std::atomic_load(&s_snapshot);
+    if (!snapshot) {
+        try {
+            tntdb::Connection conn = tntdb::connect(DBConn::url);
+            refresh(conn);
+        } catch (const std::exception& e) {
+            log_error("cannot read asset names: %s", e.what());
+        }
+        snapshot = std::atomic_load(&s_snapshot);
+    }
+    if (!snapshot) {
+        return empty;
+    }
+    return snapshot;
+}
+
+void AssetNames::follow(bool following)
+{
+    if (following && !s_following) {
+        // names may have changed while nobody was following, read them all again
+        s_drop();
+    }
+    s_following = following;
+}
+
+bool AssetNames::loaded()
+{
+    return std::atomic_load(&s_snapshot) != nullptr;
+}
+
+bool AssetNames::refresh(tntdb::Connection& conn)
+{
+    // held over the query, so a reload done meanwhile is not overwritten by older names
+    std::lock_guard<std::mutex> lock(s_write_mutex);
+
+    auto names = select_asset_element_names(conn);
+    if (names.status == 0) {
+        log_error("cannot read asset names: %s", names.msg.c_str());
+        return false;
+    }
+
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->by_id.reserve(names.item.size());
+    snapshot->by_name.reserve(names.item.size());
+    for (const auto& name : names.item) {
+        s_add(*snapshot, name);
+    }
+    log_debug("asset names loaded, %zu assets", snapshot->by_id.size());
+
+    std::atomic_store(&s_snapshot, std::shared_ptr<const Snapshot>(std::move(snapshot)));
+    return true;
+}
+
+void AssetNames::update(const std::vector<db_a_elmnt_name_t>& names)
+{
+    if (names.empty()) {
+        return;
+    }
+    s_modify([&names](Snapshot& snapshot) {
+        for (const auto& name : names) {
+            s_add(snapshot, name);
+        }
+    });
+}
+
+void AssetNames::reload(tntdb::Connection& conn, const std::vector<a_elmnt_id_t>& ids)
+{
+    if (ids.empty() || !loaded()) {
+        return;
+    }
+    try {
+        std::vector<db_a_elmnt_name_t> names;
+        for (const auto& in : shared::sql_in_lists(ids)) {
+            auto chunk = s_select(conn, "v.id IN (" + in + ")", {});
+            std::move(chunk.begin(), chunk.end(), std::back_inserter(names));
+        }
+
+        s_modify([&ids, &names](Snapshot& snapshot) {
+            for (auto id : ids) {
+                s_remove(snapshot, id);
+            }
+            for (const auto& name : names) {
+                s_add(snapshot, name);
+            }
+        });
+    } catch (const std::exception& e) {
+        log_error("cannot reload asset names: %s", e.what());
+        s_drop();
+    }
+}
+
+void AssetNames::reload(tntdb::Connection& conn, const std::vector<std::string>& names)
+{
+    if (names.empty() || !loaded()) {
+        return;
+    }
+    try {
+        std::vector<db_a_elmnt_name_t> found;
+        for (const auto& values : shared::sql_in_chunks(names)) {
+            auto chunk = s_select(conn, "v.name IN (" + shared::sql_in_placeholders(values.size()) + ")", values);
+            std::move(chunk.begin(), chunk.end(), std::back_inserter(found));
+        }
+
+        s_modify([&names, &found](Snapshot& snapshot) {
+            for (const auto& name : names) {
+                auto it = snapshot.by_name.find(s_key(name));
+                if (it != snapshot.by_name.end()) {
+                    s_remove(snapshot, it->second);
+                }
+            }
+            for (const auto& name : found) {
+                s_add(snapshot, name);
+            }
+        });
+    } catch (const std::exception& e) {
+        log_error("cannot reload asset names: %s", e.what());
+        s_drop();
+    }
+}
+
+void AssetNames::reload(const std::vector<std::string>& names)
+{
+    if (names.empty() || !loaded()) {
+        return;
+    }
+    try {
+        tntdb::Connection conn = tntdb::connect(DBConn::url);
+        reload(conn, names);
+    } catch (const std::exception& e) {
+        log_error("cannot reload asset names: %s", e.what());
+        s_drop();
+    }
+}
+
+std::pair<std::string, std::string> AssetNames::id_to_name_ext_name(a_elmnt_id_t id)
+{
+    auto snapshot = get();
+    auto it       = snapshot->by_id.find(id);
+    if (it != snapshot->by_id.end()) {
+        return it->second;
+    }
+    return DBAssets::id_to_name_ext_name(id);
+}
+
+std::vector<std::string> AssetNames::id_to_name(const std::vector<a_elmnt_id_t>& ids)
+{
+    auto                     snapshot = get();
+    std::vector<std::string> names;
+    names.reserve(ids.size());
+    for (auto id : ids) {
+        auto        it   = snapshot->by_id.find(id);
+        std::string name = it != snapshot->by_id.end() ? it->second.first : DBAssets::id_to_name_ext_name(id).first;
+        if (!name.empty()) {
+            names.push_back(std::move(name));
+        }
+    }
+    return names;
+}
+
+int64_t AssetNames::name_to_asset_id(const std::string& name)
+{
+    auto snapshot = get();
+    auto it       = snapshot->by_name.find(s_key(name));
+    if (it != snapshot->by_name.end()) {
+        return it->second;
+    }
+    return DBAssets::name_to_asset_id(name);
+}
+
+int64_t AssetNames::extname_to_asset_id(const std::string& ext_name)
+{
+    auto snapshot = get();
+    auto it       = snapshot->by_ext_name.find(s_key(ext_name));
+    if (it != snapshot->by_ext_name.end()) {
+        return it->second;
+    }
+    return DBAssets::extname_to_asset_id(ext_name);
+}
+
+int AssetNames::name_to_extname(const std::string& name, std::string& ext_name)
+{
+    auto snapshot = get();
+    auto it       = snapshot->by_name.find(s_key(name));
+    if (it != snapshot->by_name.end()) {
+        const auto& names = snapshot->by_id.at(it->second);
+        // asset without external name is left to DB, so is its error code
+        if (!names.second.empty()) {
+            ext_name = names.second;
+            return 0;
+        }
+    }
+    return DBAssets::name_to_extname(name, ext_name);
+}
+
+int AssetNames::extname_to_asset_name(const std::string& ext_name, std::string& name)
+{
+    auto snapshot = get();
+    auto it       = snapshot->by_ext_name.find(s_key(ext_name));
+    if (it != snapshot->by_ext_name.end()) {
+        name = snapshot->by_id.at(it->second).first;
+        return 0;
+    }
+    return DBAssets::extname_to_asset_name(ext_name, name);
+}
+
+} // namespace persist
@@ -0,0 +1,105 @@
+/*
+ *
+ * Copyright (C) 2015 - 2020 Eaton
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/// @file   assetnames.h
+/// @brief  Process wide dictionary of asset ids, internal and external names
+///
+/// Names of all assets are read once and kept as an immutable snapshot which readers take without locking, as
+/// AssetDictionary does. Writers copy the snapshot, change it and swap it in; assets written by this process are
+/// re-read right after the write, assets announced on ASSETS stream are re-read by whoever follows the stream and
+/// reports it by follow(). Lookups have the same results as DBAssets functions of the same name. A name which is not
+/// in the snapshot is looked up in DB, so an asset created elsewhere is found before its announcement arrives. While
+/// nobody follows the stream, changes made elsewhere would be missed, so the snapshot is not used and every lookup
+/// goes to DB.
+#pragma once
+
+#include "dbtypes.h"
+#include "persist/assetcrud.h"
+#include <memory>
+#include <string>
+#include <tntdb/connect.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace persist {
+
+/// @class AssetNames
+class AssetNames
+{
+public:
+    struct Snapshot
+    {
+        std::unordered_map<a_elmnt_id_t, std::pair<std::string, std::string>> by_id;       // internal, external name
+        std::unordered_map<std::string, a_elmnt_id_t>                          by_name;     // lower case internal name
+        std::unordered_map<std::string, a_elmnt_id_t>                          by_ext_name; // lower case external name
+    };
+
+    /// Returns current snapshot, reads it from DB on first use
+    ///
+    /// @return snapshot, empty if the names cannot be read or ASSETS stream is not followed
+    static std::shared_ptr<const Snapshot> get();
+
+    /// Tells if announcements on ASSETS stream are followed and passed to reload()
+    ///
+    /// The snapshot is read again on next use once they are, names announced before may be missing from it.
+    static void follow(bool following);
+
+    /// return if the names were read from DB already
+    static bool loaded();
+
+    /// Reads names of all assets and replaces the current snapshot
+    ///
+    /// @return false if the names cannot be read, current snapshot is kept then
+    static bool refresh(tntdb::Connection& conn);
+
+    /// Replaces names of given assets, no DB access
+    static void update(const std::vector<db_a_elmnt_name_t>& names);
+
+    /// Reads names of given assets again, the ones not found are removed
+    static void reload(tntdb::Connection& conn, const std::vector<a_elmnt_id_t>& ids);
+
+    /// Reads names of assets of given internal names again, the ones not found are removed
+    static void reload(tntdb::Connection& conn, const std::vector<std::string>& names);
+
+    /// Same as above, connects to DB itself
+    static void reload(const std::vector<std::string>& names);
+
+    /// return internal and external name of the asset, both empty if not found
+    static std::pair<std::string, std::string> id_to_name_ext_name(a_elmnt_id_t id);
+
+    /// return internal names of given assets in the same order, unknown ones are left out
+    static std::vector<std::string> id_to_name(const std::vector<a_elmnt_id_t>& ids);
+
+    /// return id of asset with given internal name, -1 if not found, -2 on error
+    static int64_t name_to_asset_id(const std::string& name);
+
+    /// return id of asset with given external name, -1 if not found, -2 on error
+    static int64_t extname_to_asset_id(const std::string& ext_name);
+
+    /// external name of asset with given internal name, return codes are the ones of DBAssets::name_to_extname
+    static int name_to_extname(const std::string& name, std::string& ext_name);
+
+    /// internal name of asset with given external name, return codes are the ones of
+    /// DBAssets::extname_to_asset_name
+    static int extname_to_asset_name(const std::string& ext_name, std::string& name);
+};
+
+} // namespace persist
@@ -0,0 +1,323 @@
+/*
+ *
+ * Copyright (C) 2015 - 2020 Eaton
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "persist/assettree.h"
+#include "persist/assetnames.h"
+#include "shared/sql_in.h"
+#include <algorithm>
+#include <cinttypes>
+#include <fty_common.h>
+#include <fty_common_db_dbpath.h>
+#include <iterator>
+#include <mutex>
+#include <tntdb/connect.h>
+#include <tntdb/result.h>
+#include <tntdb/row.h>
+#include <tntdb/statement.h>
+
+namespace persist {
+
+static const char* TREE_SELECT =
+    " SELECT"
+    "   id_asset_element, id_parent, id_type, id_subtype, name"
+    " FROM"
+    "   t_bios_asset_element";
+
+/*
+ * \brief Reads assets the condition selects, values are bound to its placeholders :n0, :n1, ...
+ */
+static std::vector<std::pair<uint32_t, AssetTree::Node>> s_select(tntdb::Connection& conn, const std::string& condition,
+    const std::vector<std::string>& values, std::set<std::string>* names = nullptr)
+{
+    tntdb::Statement st = conn.prepare(TREE_SELECT + condition);
+    shared::sql_in_bind(st, values);
+
+    std::vector<std::pair<uint32_t, AssetTree::Node>> nodes;
+    for (const auto& row : st.select()) {
+        AssetTree::Node node;
+        row[1].get(node.parent); // stays 0 on NULL
+        row[2].get(node.type_id);
+        row[3].get(node.subtype_id);
+        nodes.emplace_back(row.getUnsigned32(0), std::move(node));
+        if (names) {
+            std::string name;
+            row[4].get(name);
+            names->insert(name);
+        }
+    }
+    return nodes;
+}
+
+AssetTree& AssetTree::instance()
+{
+    static AssetTree tree;
+    return tree;
+}
+
+std::shared_lock<std::shared_mutex> AssetTree::read()
+{
+    std::shared_lock<std::shared_mutex> lock(_mutex);
+    while (!_loaded) {
+        lock.unlock();
+        {
+            std::unique_lock<std::shared_mutex> write(_mutex);
+            if (!_loaded) {
+                load();
+            }
+        }
+        lock.lock();
+    }
+    return lock;
+}
+
+bool AssetTree::known(uint32_t id)
+{
+    auto lock = read();
+    return _nodes.count(id) != 0;
+}
+
+bool AssetTree::contains(uint32_t container, uint32_t id)
+{
+    auto lock = read();
+    auto it   = _nodes.find(id);
+    if (it == _nodes.end()) {
+        return false;
+    }
+    const auto& ancestors = it->second.ancestors;
+    return std::find(ancestors.begin(), ancestors.end(), container) != ancestors.end();
+}
+
+std::vector<uint32_t> AssetTree::descendants(
+    uint32_t container, const std::set<uint16_t>& types, const std::set<uint16_t>& subtypes)
+{
+    auto lock = read();
+
+    std::vector<uint32_t> ret;
+    std::vector<uint32_t> stack{container};
+    // a loop made by a move which is not announced yet must not hang the walk
+    size_t visited = 0;
+    while (!stack.empty() && visited++ <= _nodes.size()) {
+        auto children = _children.find(stack.back());
+        stack.pop_back();
+        if (children == _children.end()) {
+            continue;
+        }
+        for (auto child : children->second) {
+            const Node& node = _nodes.at(child);
+            if ((types.empty() || types.count(node.type_id)) && (subtypes.empty() || subtypes.count(node.subtype_id))) {
+                ret.push_back(child);
+            }
+            stack.push_back(child);
+        }
+    }
+    return ret;
+}
+
+std::vector<uint32_t> AssetTree::path(uint32_t id)
+{
+    auto lock = read();
+    auto it   = _nodes.find(id);
+    return it == _nodes.end() ? std::vector<uint32_t>{} : it->second.ancestors;
+}
+
+void AssetTree::reload(tntdb::Connection& conn, const std::vector<uint32_t>& ids)
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(_mutex);
+        if (ids.empty() || !_loaded) {
+            return;
+        }
+    }
+    try {
+        std::vector<std::pair<uint32_t, Node>> nodes;
+        for (const auto& in : shared::sql_in_lists(ids)) {
+            auto chunk = s_select(conn, " WHERE id_asset_element IN (" + in + ")", {});
+            std::move(chunk.begin(), chunk.end(), std::back_inserter(nodes));
+        }
+
+        std::unique_lock<std::shared_mutex> lock(_mutex);
+        std::set<uint32_t>                  found;
+        for (const auto& it : nodes) {
+            set(it.first, it.second);
+            found.insert(it.first);
+        }
+        for (auto id : ids) {
+            if (!found.count(id)) {
+                remove(id);
+            }
+        }
+    } catch (const std::exception& e) {
+        log_error("cannot reload asset tree: %s", e.what());
+        invalidate_all();
+    }
+}
+
+void AssetTree::reload(tntdb::Connection& conn, const std::vector<std::string>& names)
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(_mutex);
+        if (names.empty() || !_loaded) {
+            return;
+        }
+    }
+    try {
+        std::vector<std::pair<uint32_t, Node>> nodes;
+        std::set<std::string>                  found;
+        for (const auto& values : shared::sql_in_chunks(names)) {
+            auto chunk =
+                s_select(conn, " WHERE name IN (" + shared::sql_in_placeholders(values.size()) + ")", values, &found);
+            std::move(chunk.begin(), chunk.end(), std::back_inserter(nodes));
+        }
+
+        // deleted assets are known by their names only, the dictionary still has them
+        std::vector<uint32_t> deleted;
+        for (const auto& name : names) {
+            if (!found.count(name)) {
+                int64_t id = AssetNames::name_to_asset_id(name);
+                if (id > 0) {
+                    deleted.push_back(uint32_t(id));
+                }
+            }
+        }
+
+        std::unique_lock<std::shared_mutex> lock(_mutex);
+        for (const auto& it : nodes) {
+            set(it.first, it.second);
+        }
+        for (auto id : deleted) {
+            remove(id);
+        }
+    } catch (const std::exception& e) {
+        log_error("cannot reload asset tree: %s", e.what());
+        invalidate_all();
+    }
+}
+
+void AssetTree::invalidate_all()
+{
+    std::unique_lock<std::shared_mutex> lock(_mutex);
+    _loaded = false;
+    _nodes.clear();
+    _children.clear();
+}
+
+void AssetTree::load()
+{
+    tntdb::Connection conn  = tntdb::connect(DBConn::url);
+    auto              nodes = s_select(conn, "", {});
+
+    _nodes.clear();
+    _children.clear();
+    _nodes.reserve(nodes.size());
+    for (auto& it : nodes) {
+        if (it.second.parent) {
+            _children[it.second.parent].push_back(it.first);
+        }
+        _nodes.emplace(it.first, std::move(it.second));
+    }
+    // chains go from top level assets down, an asset with unknown parent starts its own
+    for (const auto& it : _nodes) {
+        if (!it.second.parent || !_nodes.count(it.second.parent)) {
+            link(it.first);
+        }
+    }
+    _loaded = true;
+    log_debug("asset tree loaded, %zu assets", _nodes.size());
+}
+
+void AssetTree::set(uint32_t id, const Node& node)
+{
+    auto it = _nodes.find(id);
+    if (it != _nodes.end() && it->second.parent == node.parent) {
+        it->second.type_id    = node.type_id;
+        it->second.subtype_id = node.subtype_id;
+        return;
+    }
+    if (it != _nodes.end()) {
+        remove(id);
+    }
+    _nodes[id] = Node{node.parent, node.type_id, node.subtype_id, {}};
+    if (node.parent) {
+        _children[node.parent].push_back(id);
+    }
+    link(id);
+}
+
+void AssetTree::remove(uint32_t id)
+{
+    auto it = _nodes.find(id);
+    if (it == _nodes.end()) {
+        return;
+    }
+    auto siblings = _children.find(it->second.parent);
+    if (siblings != _children.end()) {
+        siblings->second.erase(std::remove(siblings->second.begin(), siblings->second.end(), id),
+            siblings->second.end());
+        if (siblings->second.empty()) {
+            _children.erase(siblings);
+        }
+    }
+    _nodes.erase(it);
+    // children left behind start their chains by the removed parent
+    link(id);
+}
+
+/*
+ * \brief Computes chains of ancestors of the asset and of its whole subtree, the asset itself may be unknown
+ */
+void AssetTree::link(uint32_t id)
+{
+    std::vector<uint32_t> stack;
+    auto                  self = _nodes.find(id);
+    if (self == _nodes.end()) {
+        auto children = _children.find(id);
+        if (children != _children.end()) {
+            stack = children->second;
+        }
+    } else {
+        stack.push_back(id);
+    }
+
+    while (!stack.empty()) {
+        uint32_t current = stack.back();
+        stack.pop_back();
+        Node& node = _nodes.at(current);
+        node.ancestors.clear();
+        if (node.parent) {
+            node.ancestors.push_back(node.parent);
+            auto parent = _nodes.find(node.parent);
+            if (parent != _nodes.end()) {
+                node.ancestors.insert(
+                    node.ancestors.end(), parent->second.ancestors.begin(), parent->second.ancestors.end());
+            }
+        }
+        if (std::find(node.ancestors.begin(), node.ancestors.end(), current) != node.ancestors.end()) {
+            // move which is not announced yet made a loop, next reload fixes it
+            log_warning("asset %" PRIu32 " is its own ancestor", current);
+            continue;
+        }
+        auto children = _children.find(current);
+        if (children != _children.end()) {
+            stack.insert(stack.end(), children->second.begin(), children->second.end());
+        }
+    }
+}
+
+} // namespace persist
@@ -0,0 +1,108 @@
+/*
+ *
+ * Copyright (C) 2015 - 2020 Eaton
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/// @file   assettree.h
+/// @brief  Process wide index of the asset location tree
+///
+/// Parent, type and subtype of all assets are read by one query, children of every asset and the chain of its
+/// ancestors are kept next to them, so containment is answered without DB. Assets written by this process are
+/// re-read right after the write, assets announced on ASSETS stream are re-read by the listener of
+/// shared::AssetJsonCache. A moved asset gets the chains of its whole subtree computed again.
+#pragma once
+
+#include <cstdint>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <tntdb/connection.h>
+#include <unordered_map>
+#include <vector>
+
+namespace persist {
+
+/// @class AssetTree
+class AssetTree
+{
+public:
+    struct Node
+    {
+        uint32_t              parent     = 0;
+        uint16_t              type_id    = 0;
+        uint16_t              subtype_id = 0;
+        std::vector<uint32_t> ancestors; // parent first, root last
+    };
+
+    /// return the process wide index
+    static AssetTree& instance();
+
+    AssetTree(const AssetTree&) = delete;
+    AssetTree& operator=(const AssetTree&) = delete;
+
+    /// return if the asset is in the index
+    ///
+    /// @throws std::exception if the index cannot be read from database
+    bool known(uint32_t id);
+
+    /// return if the asset is under the container at any depth
+    ///
+    /// @throws std::exception if the index cannot be read from database
+    bool contains(uint32_t container, uint32_t id);
+
+    /// Returns assets under the container at any depth, every parent before its children
+    ///
+    /// @param[in] container - asset the descendants are looked for
+    /// @param[in] types     - only assets of these types are returned, empty for all
+    /// @param[in] subtypes  - only assets of these subtypes are returned, empty for all
+    /// @throws std::exception if the index cannot be read from database
+    std::vector<uint32_t> descendants(
+        uint32_t container, const std::set<uint16_t>& types = {}, const std::set<uint16_t>& subtypes = {});
+
+    /// Returns ancestors of the asset, parent first, empty for top level or unknown asset
+    ///
+    /// @throws std::exception if the index cannot be read from database
+    std::vector<uint32_t> path(uint32_t id);
+
+    /// Reads given assets again, the ones not found are removed
+    void reload(tntdb::Connection& conn, const std::vector<uint32_t>& ids);
+
+    /// Reads assets of given internal names again, the ones not found are removed
+    void reload(tntdb::Connection& conn, const std::vector<std::string>& names);
+
+    /// Reads everything again on the next use
+    void invalidate_all();
+
+private:
+    AssetTree() = default;
+
+    // takes the shared lock, the index is read first if needed
+    std::shared_lock<std::shared_mutex> read();
+
+    void load();
+    void set(uint32_t id, const Node& node);
+    void remove(uint32_t id);
+    void link(uint32_t id);
+
+    std::shared_mutex                                   _mutex;
+    std::unordered_map<uint32_t, Node>                  _nodes;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> _children; // parent -> its children, parent may be unknown
+    bool                                                _loaded = false;
+};
+
+} // namespace persist
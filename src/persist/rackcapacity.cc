@@ -0,0 +1,352 @@
+/*
+ *
+ * Copyright (C) 2015 - 2020 Eaton
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "persist/rackcapacity.h"
+#include "shared/sql_in.h"
+#include "shared/utils.h"
+#include <fty_common.h>
+#include <fty_common_asset_types.h>
+#include <iterator>
+#include <tntdb/result.h>
+#include <tntdb/row.h>
+#include <tntdb/statement.h>
+
+namespace persist {
+
+constexpr std::chrono::seconds RackCapacity::TTL;
+
+// with more changed assets or affected racks everything is computed again, so IN lists stay reasonably long
+static const size_t MAX_PARTIAL = 1000;
+
+// parents of v_bios_asset_element_super_parent
+static const size_t MAX_PARENTS = 10;
+
+// asset contained in a rack
+struct Content
+{
+    uint32_t id;
+    uint16_t subtype_id;
+    uint32_t u_size;
+    uint32_t outlet_count;
+};
+
+/*
+ * \brief Join condition of rack r being any of parents of v_bios_asset_element_super_parent sp
+ */
+static std::string s_rack_is_parent()
+{
+    std::string ret = " r.id_asset_element IN (";
+    for (size_t i = 1; i <= MAX_PARENTS; ++i) {
+        ret += (i == 1 ? "sp.id_parent" : ", sp.id_parent") + std::to_string(i);
+    }
+    return ret + ")";
+}
+
+/*
+ * \brief u_size as number, 0 if missing or invalid, so it does not count
+ */
+static uint32_t s_u_size(const tntdb::Value& value)
+{
+    if (value.isNull()) {
+        return 0;
+    }
+    uint32_t ret = string_to_uint32(value.getString().c_str());
+    return ret == UINT32_MAX ? 0 : ret;
+}
+
+/*
+ * \brief outlet.count as number, UINT32_MAX if missing or invalid
+ */
+static uint32_t s_outlet_count(const tntdb::Value& value)
+{
+    if (value.isNull()) {
+        return UINT32_MAX;
+    }
+    std::string count = value.getString();
+    auto        dot_i = count.find('.');
+    if (dot_i != std::string::npos) {
+        count.erase(dot_i);
+    }
+    // validation: too big values in DB are weird
+    // we're not going to have epdu with more 10K+ outlets
+    if (count.size() > 5) {
+        return UINT32_MAX;
+    }
+    return string_to_uint32(count.c_str());
+}
+
+RackCapacity& RackCapacity::instance()
+{
+    static RackCapacity capacity;
+    return capacity;
+}
+
+RackCapacity::Rack RackCapacity::get(tntdb::Connection& conn, uint32_t rack_id)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    refresh(conn);
+    auto it = _racks.find(rack_id);
+    return it == _racks.end() ? Rack() : it->second;
+}
+
+std::map<uint32_t, RackCapacity::Rack> RackCapacity::racks(tntdb::Connection& conn)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    refresh(conn);
+    return _racks;
+}
+
+void RackCapacity::invalidate(uint32_t id)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_built) {
+        _pending.insert(id);
+    }
+}
+
+void RackCapacity::invalidate_all()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _built = false;
+    _pending.clear();
+}
+
+void RackCapacity::refresh(tntdb::Connection& conn)
+{
+    auto now = std::chrono::steady_clock::now();
+    if (!_built || now - _updated >= TTL || _pending.size() > MAX_PARTIAL) {
+        // stays unbuilt if any query fails
+        _built = false;
+        _pending.clear();
+        std::set<uint32_t> sources;
+        reload_links(conn, nullptr, sources);
+        rebuild(conn, nullptr);
+        _updated = now;
+        _built   = true;
+        log_debug("rack capacity index built, %zu racks", _racks.size());
+        return;
+    }
+    if (_pending.empty()) {
+        return;
+    }
+
+    std::set<uint32_t> changed;
+    changed.swap(_pending);
+    try {
+        // racks the changed assets were in, or are racks themselves
+        std::set<uint32_t> racks;
+        for (uint32_t id : changed) {
+            if (_racks.count(id) != 0) {
+                racks.insert(id);
+            }
+            auto placement = _placement.find(id);
+            if (placement != _placement.end()) {
+                racks.insert(placement->second.begin(), placement->second.end());
+            }
+        }
+
+        // racks of power devices which got or lost links
+        std::set<uint32_t> sources;
+        reload_links(conn, &changed, sources);
+        for (uint32_t id : sources) {
+            auto placement = _placement.find(id);
+            if (placement != _placement.end()) {
+                racks.insert(placement->second.begin(), placement->second.end());
+            }
+        }
+
+        // racks the changed assets are in now, and new racks
+        for (const auto& in : shared::sql_in_lists(changed)) {
+            for (const auto& row :
+                conn.prepare(" SELECT r.id_asset_element"
+                             " FROM v_bios_asset_element_super_parent sp"
+                             " JOIN t_bios_asset_element r ON" + s_rack_is_parent() +
+                             " JOIN t_bios_asset_element_type t ON t.id_asset_element_type = r.id_type"
+                             " WHERE t.name = 'rack' AND sp.id_asset_element IN (" + in + ")")
+                    .select()) {
+                racks.insert(row.getUnsigned32(0));
+            }
+            for (const auto& row :
+                conn.prepare(" SELECT r.id_asset_element"
+                             " FROM t_bios_asset_element r"
+                             " JOIN t_bios_asset_element_type t ON t.id_asset_element_type = r.id_type"
+                             " WHERE t.name = 'rack' AND r.id_asset_element IN (" + in + ")")
+                    .select()) {
+                racks.insert(row.getUnsigned32(0));
+            }
+        }
+
+        if (racks.size() > MAX_PARTIAL) {
+            rebuild(conn, nullptr);
+        } else if (!racks.empty()) {
+            rebuild(conn, &racks);
+        }
+        log_debug("rack capacity of %zu racks computed again for %zu changed assets", racks.size(), changed.size());
+    } catch (...) {
+        // partial state, build everything next time
+        _built = false;
+        throw;
+    }
+}
+
+void RackCapacity::reload_links(tntdb::Connection& conn, const std::set<uint32_t>* ids, std::set<uint32_t>& sources)
+{
+    std::vector<std::string> filters{""};
+    if (ids == nullptr) {
+        _links.clear();
+        _used.clear();
+    } else {
+        // forget links to or from the changed assets, they are read again
+        for (auto it = _links.begin(); it != _links.end();) {
+            bool  dest_changed = ids->count(it->first) != 0;
+            auto& srcs         = it->second;
+            for (auto src = srcs.begin(); src != srcs.end();) {
+                if (dest_changed || ids->count(*src) != 0) {
+                    sources.insert(*src);
+                    if (--_used[*src] <= 0) {
+                        _used.erase(*src);
+                    }
+                    src = srcs.erase(src);
+                } else {
+                    ++src;
+                }
+            }
+            it = srcs.empty() ? _links.erase(it) : std::next(it);
+        }
+        filters.clear();
+        for (const auto& in : shared::sql_in_lists(*ids)) {
+            filters.push_back(" WHERE l.id_asset_device_dest IN (" + in + ") OR l.id_asset_device_src IN (" + in + ")");
+        }
+    }
+
+    // link between assets of different chunks is selected by both of them
+    std::set<std::pair<uint32_t, uint32_t>> links;
+    for (const auto& filter : filters) {
+        for (const auto& row :
+            conn.prepare(" SELECT l.id_asset_device_src, l.id_asset_device_dest FROM t_bios_asset_link l" + filter)
+                .select()) {
+            links.emplace(row.getUnsigned32(0), row.getUnsigned32(1));
+        }
+    }
+    for (const auto& link : links) {
+        _links[link.second].push_back(link.first);
+        ++_used[link.first];
+        sources.insert(link.first);
+    }
+}
+
+void RackCapacity::rebuild(tntdb::Connection& conn, const std::set<uint32_t>* racks)
+{
+    std::vector<std::string> filters{""};
+    if (racks == nullptr) {
+        _racks.clear();
+        _placement.clear();
+    } else {
+        for (uint32_t rack : *racks) {
+            _racks.erase(rack);
+        }
+        for (auto it = _placement.begin(); it != _placement.end();) {
+            for (uint32_t rack : *racks) {
+                it->second.erase(rack);
+            }
+            it = it->second.empty() ? _placement.erase(it) : std::next(it);
+        }
+        filters.clear();
+        for (const auto& in : shared::sql_in_lists(*racks)) {
+            filters.push_back(" AND r.id_asset_element IN (" + in + ")");
+        }
+    }
+
+    // u_size of racks, 0 if unknown
+    std::map<uint32_t, uint32_t> sizes;
+    // everything inside racks, at any depth, as select_assets_by_container gives it
+    std::map<uint32_t, std::vector<Content>> contents;
+    for (const auto& filter : filters) {
+        for (const auto& row : conn.prepare(" SELECT r.id_asset_element, u.value"
+                                            " FROM t_bios_asset_element r"
+                                            " JOIN t_bios_asset_element_type t ON t.id_asset_element_type = r.id_type"
+                                            " LEFT JOIN t_bios_asset_ext_attributes u"
+                                            "   ON u.id_asset_element = r.id_asset_element AND u.keytag = 'u_size'"
+                                            " WHERE t.name = 'rack'" + filter)
+                                   .select()) {
+            sizes[row.getUnsigned32(0)] = s_u_size(row[1]);
+        }
+
+        for (const auto& row :
+            conn.prepare(" SELECT r.id_asset_element, e.id_asset_element, e.id_subtype, u.value, o.value"
+                         " FROM v_bios_asset_element_super_parent sp"
+                         " JOIN t_bios_asset_element r ON" + s_rack_is_parent() +
+                         " JOIN t_bios_asset_element_type t ON t.id_asset_element_type = r.id_type"
+                         " JOIN t_bios_asset_element e ON e.id_asset_element = sp.id_asset_element"
+                         " LEFT JOIN t_bios_asset_ext_attributes u"
+                         "   ON u.id_asset_element = e.id_asset_element AND u.keytag = 'u_size'"
+                         " LEFT JOIN t_bios_asset_ext_attributes o"
+                         "   ON o.id_asset_element = e.id_asset_element AND o.keytag = 'outlet.count'"
+                         " WHERE t.name = 'rack'" + filter)
+                .select()) {
+            Content content;
+            content.id         = row.getUnsigned32(1);
+            content.subtype_id = 0;
+            row[2].get(content.subtype_id);
+            content.u_size       = s_u_size(row[3]);
+            content.outlet_count = s_outlet_count(row[4]);
+            contents[row.getUnsigned32(0)].push_back(content);
+        }
+    }
+
+    for (const auto& it : sizes) {
+        Rack        rack;
+        const auto& devices = contents[it.first];
+
+        if (it.second != 0) {
+            uint32_t used = 0;
+            for (const auto& device : devices) {
+                used += device.u_size;
+            }
+            // devices of which none has u_size leave free space unknown, as it always was
+            if (devices.empty() || used != 0) {
+                rack.free_u_size = int(it.second) - int(used);
+            }
+        }
+
+        int  sum     = -1;
+        bool tainted = false;
+        for (const auto& device : devices) {
+            _placement[device.id].insert(it.first);
+            if (!persist::is_epdu(int(device.subtype_id)) && !persist::is_pdu(int(device.subtype_id))) {
+                continue;
+            }
+            int  outlet_count = device.outlet_count != UINT32_MAX ? int(device.outlet_count) : -1;
+            auto outlet_used  = _used.find(device.id);
+            outlet_count -= outlet_used == _used.end() ? 0 : outlet_used->second;
+            if (outlet_count >= 0) {
+                sum += outlet_count;
+            } else {
+                tainted = true;
+            }
+            rack.outlets[std::to_string(device.id)] = outlet_count;
+        }
+        rack.outlets["sum"] = tainted ? -1 : sum + 1; // sum is initialized to -1
+
+        _racks[it.first] = std::move(rack);
+    }
+}
+
+} // namespace persist
@@ -0,0 +1,99 @@
+/*
+ *
+ * Copyright (C) 2015 - 2020 Eaton
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/// @file   rackcapacity.h
+/// @brief  Process wide index of free U positions and available outlets of racks
+///
+/// Capacity of all racks is computed by three queries: u_size of racks, assets contained in racks with their u_size
+/// and outlet.count, and all power links. Assets written by this process, and assets other processes announce on
+/// ASSETS stream to the listener of shared::AssetJsonCache, are marked as changed and only racks they were or are in,
+/// or whose power devices they are linked to, are computed again on the next read. Everything is computed again once
+/// the index is older than TTL, in case an announcement was missed.
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <tntdb/connection.h>
+#include <unordered_map>
+#include <vector>
+
+namespace persist {
+
+/// @class RackCapacity
+class RackCapacity
+{
+public:
+    /// index is computed again after this time, so changes made outside of this process and not announced show up
+    static constexpr std::chrono::seconds TTL{60};
+
+    struct Rack
+    {
+        // -1 if u_size of the rack or of all its devices is unknown
+        int free_u_size = -1;
+        // available outlets by (e)pdu id, "sum" is -1 if any of them is unknown
+        std::map<std::string, int> outlets{{"sum", 0}};
+    };
+
+    /// return the process wide index
+    static RackCapacity& instance();
+
+    RackCapacity(const RackCapacity&) = delete;
+    RackCapacity& operator=(const RackCapacity&) = delete;
+
+    /// Returns capacity of the rack, the index is brought up to date first
+    ///
+    /// @param[in] conn    - the connection to database.
+    /// @param[in] rack_id - rack, unknown one has defaults of Rack
+    /// @throws std::exception if the index cannot be read from database
+    Rack get(tntdb::Connection& conn, uint32_t rack_id);
+
+    /// Returns capacity of all racks, the index is brought up to date first
+    ///
+    /// @throws std::exception if the index cannot be read from database
+    std::map<uint32_t, Rack> racks(tntdb::Connection& conn);
+
+    /// Marks the asset as changed: written, deleted, moved or its links changed
+    void invalidate(uint32_t id);
+
+    /// Computes everything again on the next read
+    void invalidate_all();
+
+private:
+    RackCapacity() = default;
+
+    void refresh(tntdb::Connection& conn);
+    void rebuild(tntdb::Connection& conn, const std::set<uint32_t>* racks);
+    void reload_links(tntdb::Connection& conn, const std::set<uint32_t>& ids, std::set<uint32_t>& sources);
+
+    std::mutex                                          _mutex;
+    std::map<uint32_t, Rack>                            _racks;
+    std::unordered_map<uint32_t, std::set<uint32_t>>    _placement; // asset -> racks it is in
+    std::unordered_map<uint32_t, std::vector<uint32_t>> _links;     // device -> power devices it is linked to
+    std::unordered_map<uint32_t, int>                   _used;      // power device -> links from it
+    std::set<uint32_t>                                  _pending;
+    std::chrono::steady_clock::time_point               _updated;
+    bool                                                _built = false;
+};
+
+} // namespace persist
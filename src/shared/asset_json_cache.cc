@@ -0,0 +1,366 @@
+/*
+Copyright (C) 2015 - 2020 Eaton
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "shared/asset_json_cache.h"
+#include "persist/assetnames.h"
+#include "persist/assettree.h"
+#include "persist/rackcapacity.h"
+#include <algorithm>
+#include <cctype>
+#include <fty_common.h>
+#include <fty_common_db_dbpath.h>
+#include <fty_common_mlm_utils.h>
+#include <fty_common_rest.h>
+#include <functional>
+#include <malamute.h>
+#include <set>
+#include <tntdb/connect.h>
+#include <vector>
+
+namespace shared {
+
+constexpr size_t               AssetJsonCache::MAX_ASSETS;
+constexpr size_t               AssetJsonCache::MAX_CHANGED;
+constexpr std::chrono::seconds AssetJsonCache::EVENT_WINDOW;
+constexpr std::chrono::seconds AssetJsonCache::RECONNECT_INTERVAL;
+
+// announced names read again by one reload at most
+static const size_t NAMES_BATCH = 1000;
+
+/*
+ * \brief Mixes value into the fingerprint
+ */
+static void s_mix(size_t& fingerprint, const char* value)
+{
+    fingerprint ^= std::hash<std::string>()(value ? value : "") + 0x9e3779b9 + (fingerprint << 6) + (fingerprint >> 2);
+}
+
+static void s_mix(size_t& fingerprint, zhash_t* hash)
+{
+    if (!hash) {
+        return;
+    }
+    for (void* value = zhash_first(hash); value; value = zhash_next(hash)) {
+        s_mix(fingerprint, zhash_cursor(hash));
+        s_mix(fingerprint, static_cast<const char*>(value));
+    }
+}
+
+/*
+ * \brief Fingerprint of ASSETS message, copies of one message received by more clients give the same one
+ */
+static size_t s_fingerprint(fty_proto_t* asset)
+{
+    size_t fingerprint = 0;
+    s_mix(fingerprint, fty_proto_name(asset));
+    s_mix(fingerprint, fty_proto_operation(asset));
+    s_mix(fingerprint, fty_proto_aux(asset));
+    s_mix(fingerprint, fty_proto_ext(asset));
+    return fingerprint;
+}
+
+/*
+ * \brief Adds ids of assets of given names to ids, as the name dictionary knows them
+ *
+ * \return false if the dictionary knows no assets at all
+ */
+static bool s_known_ids(const std::vector<std::string>& names, std::set<uint32_t>& ids)
+{
+    auto snapshot = persist::AssetNames::get();
+    if (snapshot->by_id.empty()) {
+        return false;
+    }
+    for (const auto& name : names) {
+        std::string key{name};
+        std::transform(key.begin(), key.end(), key.begin(), [](unsigned char ch) {
+            return char(std::tolower(ch));
+        });
+        auto it = snapshot->by_name.find(key);
+        if (it != snapshot->by_name.end()) {
+            ids.insert(it->second);
+        }
+    }
+    return true;
+}
+
+/*
+ * \brief Connects a consumer of ASSETS stream
+ *
+ * \return client, NULL if it cannot connect
+ */
+static mlm_client_t* s_connect()
+{
+    mlm_client_t* client      = mlm_client_new();
+    std::string   client_name = utils::generate_mlm_client_id("web.asset_json");
+    if (!client || mlm_client_connect(client, MLM_ENDPOINT, 1000, client_name.c_str()) == -1 ||
+        mlm_client_set_consumer(client, FTY_PROTO_STREAM_ASSETS, ".*") == -1) {
+        mlm_client_destroy(&client);
+    }
+    return client;
+}
+
+AssetJsonCache& AssetJsonCache::instance()
+{
+    static AssetJsonCache cache;
+    return cache;
+}
+
+AssetJsonCache::AssetJsonCache()
+{
+    _thread = std::thread(&AssetJsonCache::listener, this);
+}
+
+AssetJsonCache::~AssetJsonCache()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _cond.notify_all();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+uint64_t AssetJsonCache::revision() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _revision;
+}
+
+bool AssetJsonCache::find(uint32_t id, std::string& json)
+{
+    std::shared_ptr<const Entry> entry;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        // changes made elsewhere are not seen while ASSETS stream is not followed, json is rendered every time
+        if (!_listening || !_entries.get(id, entry)) {
+            return false;
+        }
+        if (entry->revision < _horizon) {
+            _entries.erase(id);
+            return false;
+        }
+        for (uint32_t depend : entry->depends) {
+            auto changed = _changed.find(depend);
+            if (changed != _changed.end() && changed->second > entry->revision) {
+                _entries.erase(id);
+                return false;
+            }
+        }
+    }
+    json = entry->json;
+    return true;
+}
+
+void AssetJsonCache::store(
+    uint32_t id, uint64_t revision, std::string json, const std::vector<std::pair<uint32_t, std::string>>& depends)
+{
+    auto entry      = std::make_shared<Entry>();
+    entry->json     = std::move(json);
+    entry->revision = revision;
+    entry->depends.reserve(depends.size());
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_listening || revision < _horizon) {
+            return;
+        }
+        for (const auto& depend : depends) {
+            entry->depends.push_back(depend.first);
+            if (!depend.second.empty()) {
+                _ids[depend.second] = depend.first;
+            }
+        }
+    }
+    // stale entry stored after a change is refused by find(), revision is older than the change
+    _entries.put(id, std::move(entry));
+}
+
+CacheStats AssetJsonCache::stats() const
+{
+    return _entries.stats();
+}
+
+void AssetJsonCache::invalidate_locked(uint32_t id)
+{
+    if (_changed.size() >= MAX_CHANGED && !_changed.count(id)) {
+        forget_locked();
+    }
+    _changed[id] = ++_revision;
+    _entries.erase(id);
+}
+
+void AssetJsonCache::forget_locked()
+{
+    // json read up to now is not served, older changes need not be remembered for it
+    _horizon = _revision;
+    _changed.clear();
+    _entries.clear();
+}
+
+void AssetJsonCache::invalidate(uint32_t id)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    invalidate_locked(id);
+}
+
+void AssetJsonCache::invalidate(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto                        it = _ids.find(name);
+    // no cached json shows an asset of unknown name
+    if (it != _ids.end()) {
+        invalidate_locked(it->second);
+    }
+}
+
+void AssetJsonCache::invalidate(fty_proto_t* asset)
+{
+    std::string name        = fty_proto_name(asset) ? fty_proto_name(asset) : "";
+    size_t      fingerprint = s_fingerprint(asset);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    size_t                      seen = 0;
+    if (_events.get(name, seen) && seen == fingerprint) {
+        return;
+    }
+    _events.put(name, fingerprint);
+
+    auto it = _ids.find(name);
+    if (it != _ids.end()) {
+        invalidate_locked(it->second);
+    }
+}
+
+void AssetJsonCache::listener()
+{
+    bool reported = false;
+    while (true) {
+        mlm_client_t* client = s_connect();
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (_stop) {
+                mlm_client_destroy(&client);
+                break;
+            }
+            if (!client) {
+                if (!reported) {
+                    log_error("cannot listen to ASSETS stream, asset json is not cached until it connects");
+                    reported = true;
+                }
+                _cond.wait_for(lock, RECONNECT_INTERVAL, [this] {
+                    return _stop;
+                });
+                continue;
+            }
+            // announcements were missed while not connected
+            forget_locked();
+            _listening = true;
+        }
+        persist::AssetNames::follow(true);
+        persist::AssetTree::instance().invalidate_all();
+        persist::RackCapacity::instance().invalidate_all();
+        if (reported) {
+            log_info("listening to ASSETS stream, asset json is cached again");
+            reported = false;
+        }
+
+        bool stopped = follow(client);
+        persist::AssetNames::follow(false);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _listening = false;
+        }
+        mlm_client_destroy(&client);
+        if (stopped) {
+            break;
+        }
+        log_error("connection to ASSETS stream lost, asset json is not cached until it connects again");
+        reported = true;
+    }
+}
+
+bool AssetJsonCache::follow(mlm_client_t* client)
+{
+    zpoller_t* poller  = zpoller_new(mlm_client_msgpipe(client), NULL);
+    bool       stopped = false;
+
+    // names of announced assets, read again once the burst of announcements is over
+    std::vector<std::string> changed;
+    while (true) {
+        void* which = zpoller_wait(poller, changed.empty() ? 1000 : 0);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_stop) {
+                stopped = true;
+                break;
+            }
+        }
+
+        if (which) {
+            zmsg_t* msg = mlm_client_recv(client);
+            if (msg && fty_proto_is(msg)) {
+                fty_proto_t* asset = fty_proto_decode(&msg);
+                if (asset && fty_proto_id(asset) == FTY_PROTO_ASSET) {
+                    invalidate(asset);
+                    if (fty_proto_name(asset)) {
+                        changed.push_back(fty_proto_name(asset));
+                    }
+                }
+                fty_proto_destroy(&asset);
+            }
+            zmsg_destroy(&msg);
+        } else if (zpoller_terminated(poller)) {
+            stopped = true;
+            break;
+        } else if (!mlm_client_connected(client)) {
+            // messages sent while the broker was away are lost, the client is connected again from scratch
+            break;
+        }
+
+        if (!changed.empty() && (!which || changed.size() >= NAMES_BATCH)) {
+            // racks the assets were in are recomputed by ids they had, racks they are in now by ids they have
+            std::set<uint32_t> ids;
+            bool               known = s_known_ids(changed, ids);
+            try {
+                tntdb::Connection conn = tntdb::connect(DBConn::url);
+                // tree first, it looks deleted assets up by names the dictionary still has
+                persist::AssetTree::instance().reload(conn, changed);
+                persist::AssetNames::reload(conn, changed);
+            } catch (const std::exception& e) {
+                log_error("cannot reload announced assets: %s", e.what());
+                persist::AssetTree::instance().invalidate_all();
+                // tries to connect again, drops the names if it cannot
+                persist::AssetNames::reload(changed);
+            }
+            if (known && s_known_ids(changed, ids)) {
+                for (auto id : ids) {
+                    persist::RackCapacity::instance().invalidate(id);
+                }
+            } else {
+                persist::RackCapacity::instance().invalidate_all();
+            }
+            changed.clear();
+        }
+    }
+
+    zpoller_destroy(&poller);
+    return stopped;
+}
+
+} // namespace shared
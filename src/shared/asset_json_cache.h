@@ -0,0 +1,132 @@
+/*
+Copyright (C) 2015 - 2020 Eaton
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+/// \file asset_json_cache.h
+/// \brief Process wide cache of rendered asset json
+///
+/// Every invalidation advances one revision counter and records it for the asset. Json is stored with the revision
+/// taken before the asset was read and with ids of all assets it shows (parent, groups, power sources, parents),
+/// and is served only while none of them changed since, so a change racing with rendering is never cached.
+/// Assets are invalidated by local writes and by ASSETS stream, which a listener thread follows. SSE sessions
+/// invalidate on the messages they receive too; the same message seen again within EVENT_WINDOW is ignored, so
+/// one change is rendered once for all sessions. The listener also has persist::AssetNames re-read names of announced
+/// assets and tells it whether the stream is followed.
+///
+/// Changes made elsewhere are seen only while the listener is connected. Until then, and whenever the connection is
+/// lost, nothing is served from the cache and the listener connects again every RECONNECT_INTERVAL; json cached
+/// before is not served after it reconnects. Records of changes are bounded by MAX_CHANGED, more of them drop all
+/// cached json instead.
+
+#pragma once
+
+#include "shared/lru_cache.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fty_proto.h>
+#include <malamute.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace shared {
+
+/// @class AssetJsonCache
+class AssetJsonCache
+{
+public:
+    /// cached json of more assets evicts the least recently used ones
+    static constexpr size_t MAX_ASSETS = 20000;
+
+    /// changed assets remembered at most, more changes drop all cached json
+    static constexpr size_t MAX_CHANGED = 4 * MAX_ASSETS;
+
+    /// the same ASSETS message received again within this time is not a new change
+    static constexpr std::chrono::seconds EVENT_WINDOW{10};
+
+    /// listener which cannot connect to ASSETS stream tries again after this
+    static constexpr std::chrono::seconds RECONNECT_INTERVAL{10};
+
+    /// return the process wide cache, listener thread is started by the first use
+    static AssetJsonCache& instance();
+
+    AssetJsonCache(const AssetJsonCache&) = delete;
+    AssetJsonCache& operator=(const AssetJsonCache&) = delete;
+    ~AssetJsonCache();
+
+    /// return current revision, to be taken before the asset is read and passed to store()
+    uint64_t revision() const;
+
+    /// Finds json of the asset
+    ///
+    /// @return false if not cached, any of shown assets changed since it was read or ASSETS stream is not followed
+    bool find(uint32_t id, std::string& json);
+
+    /// Stores json of the asset
+    ///
+    /// @param[in] id       - asset
+    /// @param[in] revision - revision() taken before the asset was read
+    /// @param[in] json     - rendered asset
+    /// @param[in] depends  - ids and names of all assets the json shows, the asset itself included
+    void store(
+        uint32_t id, uint64_t revision, std::string json, const std::vector<std::pair<uint32_t, std::string>>& depends);
+
+    /// return hit, miss and eviction counters of cached json
+    CacheStats stats() const;
+
+    /// Marks the asset as changed, json of all assets showing it is rendered again
+    void invalidate(uint32_t id);
+
+    void invalidate(const std::string& name);
+
+    /// Invalidates the asset ASSETS message is about, unless the same message was seen within EVENT_WINDOW
+    void invalidate(fty_proto_t* asset);
+
+private:
+    AssetJsonCache();
+
+    void listener();
+    bool follow(mlm_client_t* client);
+    void invalidate_locked(uint32_t id);
+    void forget_locked();
+
+    struct Entry
+    {
+        std::string           json;
+        uint64_t              revision;
+        std::vector<uint32_t> depends;
+    };
+
+    mutable std::mutex                               _mutex;
+    std::condition_variable                          _cond; // stop
+    uint64_t                                         _revision = 0;
+    uint64_t                                         _horizon  = 0; // json read before is not served
+    LruCache<uint32_t, std::shared_ptr<const Entry>> _entries{MAX_ASSETS};
+    std::unordered_map<uint32_t, uint64_t>           _changed; // revision the asset changed at
+    std::unordered_map<std::string, uint32_t>        _ids;     // names of assets cached json shows
+    LruCache<std::string, size_t>                    _events{MAX_ASSETS, EVENT_WINDOW}; // last ASSETS message by name
+    bool                                             _listening = false; // ASSETS stream is followed
+    bool                                             _stop      = false;
+    std::thread                                      _thread;
+};
+
+} // namespace shared
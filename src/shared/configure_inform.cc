@@ -19,12 +19,15 @@
  */
 
 #include "shared/configure_inform.h"
+#include "shared/sql_in.h"
 #include <fty_common.h>
 #include <fty_common_db_asset_insert.h>
 #include <fty_common_db_dbpath.h>
 #include <fty_common_mlm_utils.h>
 #include <fty_proto.h>
 #include <malamute.h>
+#include <map>
+#include <set>
 #include <stdexcept>
 
 static zhash_t* s_map2zhash(const std::map<std::string, std::string>& m)
@@ -37,15 +40,51 @@ static zhash_t* s_map2zhash(const std::map<std::string, std::string>& m)
     return ret;
 }
 
-void send_configure(
-    const std::vector<std::pair<db_a_elmnt_t, persist::asset_operation>>& rows, const std::string& agent_name)
+// parent names are parent_name1 .. parent_name10, closest parent first
+static const size_t MAX_PARENTS = 10;
+
+/*
+ * \brief Reads parent names of all rows of the batch, in chunks of SQL_IN_CHUNK assets
+ */
+static std::map<a_elmnt_id_t, std::vector<std::string>> s_select_super_parents(
+    tntdb::Connection& conn, const ConfigurePublisher::rows_t& rows)
 {
-    mlm_client_t* client = mlm_client_new();
+    std::map<a_elmnt_id_t, std::vector<std::string>> ret;
+
+    std::string columns;
+    for (size_t i = 1; i <= MAX_PARENTS; ++i) {
+        columns += ", v.parent_name" + std::to_string(i);
+    }
+    std::vector<a_elmnt_id_t> ids;
+    for (const auto& it : rows) {
+        ids.push_back(it.first.id);
+    }
+    for (const auto& in : shared::sql_in_lists(ids)) {
+        for (const auto& row : conn.prepare(" SELECT v.id_asset_element" + columns +
+                                            " FROM v_bios_asset_element_super_parent v"
+                                            " WHERE v.id_asset_element IN (" + in + ")")
+                                   .select()) {
+            auto& names = ret[row.getUnsigned32(0)];
+            names.resize(MAX_PARENTS);
+            for (size_t i = 0; i != MAX_PARENTS; ++i) {
+                row[i + 1].get(names[i]);
+            }
+        }
+    }
+    return ret;
+}
 
+/*
+ * \brief Connects the producer of ASSETS stream
+ */
+static mlm_client_t* s_connect()
+{
+    mlm_client_t* client = mlm_client_new();
     if (client == NULL) {
         throw std::runtime_error(" mlm_client_new () failed.");
     }
-    int r = mlm_client_connect(client, MLM_ENDPOINT, 1000, agent_name.c_str());
+    std::string client_name = utils::generate_mlm_client_id("web.configure");
+    int         r           = mlm_client_connect(client, MLM_ENDPOINT, 1000, client_name.c_str());
     if (r == -1) {
         mlm_client_destroy(&client);
         throw std::runtime_error(" mlm_client_connect () failed.");
@@ -56,7 +95,20 @@ void send_configure(
         mlm_client_destroy(&client);
         throw std::runtime_error(" mlm_client_set_producer () failed.");
     }
-    tntdb::Connection conn = tntdb::connect(DBConn::url);
+    return client;
+}
+
+/*
+ * \brief Sends ASSETS messages of the batch, asks for republish of written assets and sends inventory of
+ * datacenters with changed upses once per batch
+ */
+static void s_send_batch(mlm_client_t* client, const ConfigurePublisher::rows_t& rows)
+{
+    tntdb::Connection conn    = tntdb::connect(DBConn::url);
+    auto              parents = s_select_super_parents(conn, rows);
+
+    std::vector<std::string> republish;
+    std::set<std::string>    ups_dcs;
     for (const auto& oneRow : rows) {
 
         std::string s_priority   = std::to_string(oneRow.first.priority);
@@ -82,73 +134,191 @@ void send_configure(
         // this is a bit hack, but we now that our topology ends with datacenter (hopefully)
         std::string dc_name;
 
-        std::function<void(const tntdb::Row&)> cb = [aux, &dc_name](const tntdb::Row& row) {
-            for (const auto& name :
-                 {"parent_name1", "parent_name2", "parent_name3", "parent_name4", "parent_name5", "parent_name6",
-                  "parent_name7", "parent_name8", "parent_name9", "parent_name10"}) {
-                std::string foo;
-                row[name].get(foo);
-                std::string hash_name = name;
-                //                11 == strlen ("parent_name")
-                hash_name.insert(11, 1, '.');
-                if (!foo.empty()) {
-                    zhash_insert(aux, hash_name.c_str(), const_cast<char*>(foo.c_str()));
-                    dc_name = foo;
+        auto it = parents.find(oneRow.first.id);
+        if (it != parents.end()) {
+            for (size_t i = 0; i != it->second.size(); ++i) {
+                const std::string& name = it->second[i];
+                if (!name.empty()) {
+                    std::string hash_name = "parent_name." + std::to_string(i + 1);
+                    zhash_insert(aux, hash_name.c_str(), const_cast<char*>(name.c_str()));
+                    dc_name = name;
                 }
             }
-        };
-        r = DBAssets::select_asset_element_super_parent(conn, oneRow.first.id, cb);
-        if (r == -1) {
-            zhash_destroy(&aux);
-            mlm_client_destroy(&client);
-            throw std::runtime_error("persist::select_asset_element_super_parent () failed.");
         }
 
         zhash_t* ext = s_map2zhash(oneRow.first.ext);
 
         zmsg_t* msg = fty_proto_encode_asset(aux, oneRow.first.name.c_str(), operation2str(oneRow.second).c_str(), ext);
+        zhash_destroy(&aux);
+        zhash_destroy(&ext);
 
-        r = mlm_client_send(client, subject.c_str(), &msg);
+        int r = mlm_client_send(client, subject.c_str(), &msg);
         if (r != 0) {
-            mlm_client_destroy(&client);
             throw std::runtime_error("mlm_client_send () failed.");
         }
 
-        zhash_destroy(&aux);
-        zhash_destroy(&ext);
-
         // ask fty-asset to republish so we would get UUID
         if (streq(operation2str(oneRow.second).c_str(), FTY_PROTO_ASSET_OP_CREATE) ||
             streq(operation2str(oneRow.second).c_str(), FTY_PROTO_ASSET_OP_UPDATE)) {
-            zmsg_t* republish = zmsg_new();
-            zmsg_addstr(republish, s_asset_name.c_str());
-            mlm_client_sendto(client, "asset-agent", "REPUBLISH", NULL, 5000, &republish);
+            republish.push_back(s_asset_name);
         }
 
         // data for uptime
         if (oneRow.first.subtype_id == persist::asset_subtype::UPS) {
-            zhash_t* aux1 = zhash_new();
-
-            if (!DBUptime::get_dc_upses(dc_name.c_str(), aux1))
-                log_error("Cannot read upses for dc with id = %s", dc_name.c_str());
-
-            zhash_update(aux1, "type", const_cast<char*>("datacenter"));
-            zmsg_t*     msg1     = fty_proto_encode_asset(aux1, dc_name.c_str(), "inventory", NULL);
-            std::string subject1 = "datacenter.unknown@";
-            subject1.append(dc_name);
-            r = mlm_client_send(client, subject1.c_str(), &msg1);
-            zhash_destroy(&aux1);
-            if (r != 0) {
-                mlm_client_destroy(&client);
-                throw std::runtime_error("mlm_client_send () failed.");
+            ups_dcs.insert(dc_name);
+        }
+    }
+
+    // asset-agent is asked for one asset per message
+    for (const auto& name : republish) {
+        zmsg_t* msg = zmsg_new();
+        zmsg_addstr(msg, name.c_str());
+        mlm_client_sendto(client, "asset-agent", "REPUBLISH", NULL, 5000, &msg);
+    }
+
+    for (const auto& dc_name : ups_dcs) {
+        zhash_t* aux1 = zhash_new();
+
+        if (!DBUptime::get_dc_upses(dc_name.c_str(), aux1))
+            log_error("Cannot read upses for dc with id = %s", dc_name.c_str());
+
+        zhash_update(aux1, "type", const_cast<char*>("datacenter"));
+        zmsg_t*     msg1     = fty_proto_encode_asset(aux1, dc_name.c_str(), "inventory", NULL);
+        std::string subject1 = "datacenter.unknown@";
+        subject1.append(dc_name);
+        int r = mlm_client_send(client, subject1.c_str(), &msg1);
+        zhash_destroy(&aux1);
+        if (r != 0) {
+            throw std::runtime_error("mlm_client_send () failed.");
+        }
+    }
+}
+
+ConfigurePublisher& ConfigurePublisher::instance()
+{
+    static ConfigurePublisher publisher;
+    return publisher;
+}
+
+constexpr std::chrono::seconds ConfigurePublisher::QUEUE_TIMEOUT;
+
+ConfigurePublisher::~ConfigurePublisher()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _cond.notify_all();
+    for (auto& thread : _threads) {
+        thread.join();
+    }
+}
+
+std::future<void> ConfigurePublisher::publish(rows_t rows, const std::string& agent_name)
+{
+    auto batch        = std::unique_ptr<Batch>(new Batch);
+    batch->rows       = std::move(rows);
+    batch->agent_name = agent_name;
+    for (const auto& row : batch->rows) {
+        batch->names.insert(row.first.name);
+    }
+    auto sent = batch->sent.get_future();
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    // batch larger than the limit is let in once the queue is empty
+    if (!_cond_space.wait_for(lock, QUEUE_TIMEOUT, [this, &batch] {
+            return _queued_rows == 0 || _queued_rows + batch->rows.size() <= MAX_QUEUED_ROWS;
+        })) {
+        log_error("%s: publishing queue is full, %zu assets not published", agent_name.c_str(), batch->rows.size());
+        throw std::runtime_error("publishing queue is full");
+    }
+    _queued_rows += batch->rows.size();
+    _queue.push_back(std::move(batch));
+    while (_threads.size() < WORKERS) {
+        _threads.emplace_back(&ConfigurePublisher::worker, this);
+    }
+    _cond.notify_all();
+    return sent;
+}
+
+std::unique_ptr<ConfigurePublisher::Batch> ConfigurePublisher::take()
+{
+    // first batch sharing no asset with batches being sent or queued before it, keeps order of messages per asset
+    std::set<std::string> before;
+    for (auto it = _queue.begin(); it != _queue.end(); ++it) {
+        bool blocked = false;
+        for (const auto& name : (*it)->names) {
+            if (_in_flight.count(name) || before.count(name)) {
+                blocked = true;
+                break;
             }
         }
+        if (!blocked) {
+            auto batch = std::move(*it);
+            _queue.erase(it);
+            _in_flight.insert(batch->names.begin(), batch->names.end());
+            return batch;
+        }
+        before.insert((*it)->names.begin(), (*it)->names.end());
     }
+    return nullptr;
+}
+
+void ConfigurePublisher::worker()
+{
+    mlm_client_t* client = NULL;
+    while (true) {
+        std::unique_ptr<Batch> batch;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            // queued batches are sent before the workers stop
+            _cond.wait(lock, [this, &batch] {
+                batch = take();
+                return batch || (_stop && _queue.empty());
+            });
+            if (!batch) {
+                break;
+            }
+        }
+
+        try {
+            if (client == NULL) {
+                client = s_connect();
+            }
+            s_send_batch(client, batch->rows);
+            log_debug("%s: %zu assets published", batch->agent_name.c_str(), batch->rows.size());
+            batch->sent.set_value();
+        } catch (const std::exception& e) {
+            log_error("%s: publishing of %zu assets failed: %s", batch->agent_name.c_str(), batch->rows.size(),
+                e.what());
+            // connection may be broken, next batch connects again
+            mlm_client_destroy(&client);
+            batch->sent.set_exception(std::current_exception());
+        }
 
-    zclock_sleep(500); // ensure that everything was send before we destroy the client
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _queued_rows -= batch->rows.size();
+            for (const auto& name : batch->names) {
+                _in_flight.erase(_in_flight.find(name));
+            }
+        }
+        // batches waiting for these assets may go now
+        _cond.notify_all();
+        _cond_space.notify_all();
+    }
     mlm_client_destroy(&client);
 }
 
+void send_configure(
+    const std::vector<std::pair<db_a_elmnt_t, persist::asset_operation>>& rows, const std::string& agent_name)
+{
+    if (rows.empty()) {
+        return;
+    }
+    ConfigurePublisher::instance().publish(rows, agent_name).get();
+}
+
 void send_configure(db_a_elmnt_t row, persist::asset_operation action_type, const std::string& agent_name)
 {
     send_configure(
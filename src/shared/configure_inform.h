@@ -25,11 +25,79 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #pragma once
 
 #include "db/dbhelpers.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <fty_common.h>
 #include <fty_common_db.h>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <string>
+#include <thread>
 #include <vector>
 
+/// @class ConfigurePublisher
+/// Long lived producer of ASSETS stream. Batches of written assets are queued and published by a few worker threads,
+/// each over its own client which stays connected so nothing has to wait for messages to leave before it is
+/// destroyed. Batches sharing an asset are published in the order they were queued.
+class ConfigurePublisher
+{
+public:
+    using rows_t = std::vector<std::pair<db_a_elmnt_t, persist::asset_operation>>;
+
+    /// number of worker threads
+    static const size_t WORKERS = 4;
+
+    /// publish() waits while more rows than this wait in the queue
+    static const size_t MAX_QUEUED_ROWS = 10000;
+
+    /// publish() fails if the queue has no space for the batch after this
+    static constexpr std::chrono::seconds QUEUE_TIMEOUT{30};
+
+    /// return the process wide publisher, worker threads are started by the first batch
+    static ConfigurePublisher& instance();
+
+    ConfigurePublisher(const ConfigurePublisher&) = delete;
+    ConfigurePublisher& operator=(const ConfigurePublisher&) = delete;
+    ~ConfigurePublisher();
+
+    /// Queues the batch for publishing
+    ///
+    /// @param[in] rows       - written assets
+    /// @param[in] agent_name - who wrote them, for logging
+    /// @return future ready once all messages of the batch are sent, or holding the error
+    /// @throws std::runtime_error if the queue stays full for QUEUE_TIMEOUT
+    std::future<void> publish(rows_t rows, const std::string& agent_name);
+
+private:
+    struct Batch
+    {
+        rows_t                rows;
+        std::set<std::string> names;
+        std::string           agent_name;
+        std::promise<void>    sent;
+    };
+
+    ConfigurePublisher() = default;
+
+    void                   worker();
+    std::unique_ptr<Batch> take();
+
+    std::mutex                         _mutex;
+    std::condition_variable            _cond;       // new batch, finished batch or stop
+    std::condition_variable            _cond_space; // space in the queue
+    std::deque<std::unique_ptr<Batch>> _queue;
+    std::multiset<std::string>         _in_flight;  // names of assets being sent by workers
+    size_t                             _queued_rows = 0;
+    bool                               _stop        = false;
+    std::vector<std::thread>           _threads;
+};
+
+/// Publishes written assets and waits until they are sent, see ConfigurePublisher
+///
+/// @throws std::runtime_error if the messages cannot be sent or the queue is full
 void send_configure(
     const std::vector<std::pair<db_a_elmnt_t, persist::asset_operation>>& rows, const std::string& agent_name);
 
@@ -21,71 +21,116 @@
 #include "csv.h"
 #include "persist/assetcrud.h"
 #include <algorithm>
-#include <cxxtools/csvdeserializer.h>
 #include <fty_common.h>
 #include <fty_common_macros.h>
 #include <iostream>
+#include <limits>
 #include <set>
 #include <sstream>
 #include <stdexcept>
 
 namespace shared {
 
-/* Workaround for a fact a) std::transform to do a strip and lower is weird, b) it breaks the map somehow*/
-static const std::string _ci_strip(const std::string& str)
+// keeps allowed chars [a-zA-Z0-9_\.] in lower case
+static std::string _ci_strip(std::string_view str)
 {
-    std::ostringstream b;
-
+    std::string ret;
+    ret.reserve(str.size());
     for (const char c : str) {
-        // allowed chars [a-zA-Z0-9_\.]
-        if (::isalnum(c) || c == '_' || c == '.')
-            b << static_cast<char>(::tolower(c));
+        if (::isalnum(c) || c == '_' || c == '.') {
+            ret.push_back(static_cast<char>(::tolower(c)));
+        }
     }
-
-    return b.str();
+    return ret;
 }
 
+// marks a cell missing on a short row
+static constexpr CsvDocument::Span MISSING_CELL = {std::numeric_limits<uint32_t>::max(), 0};
+
 void CsvMap::deserialize()
 {
 
-    if (_data.size() == 0) {
+    if (_data.rows() == 0) {
         throw std::invalid_argument(TRANSLATE_ME("Can't process empty data set"));
     }
 
-    size_t i = 0;
-    for (const std::string& title_name : _data[0]) {
-        std::string title = _ci_strip(title_name);
-        if (_title_to_index.count(title) == 1) {
+    const size_t cols = _data.cols(0);
+    _titles.clear();
+    _titles.reserve(cols);
+    _title_to_index.clear();
+    _title_to_index.reserve(cols);
+    for (size_t i = 0; i != cols; i++) {
+        std::string title = _ci_strip(_data.cell(0, i));
+        if (!_title_to_index.emplace(title, i).second) {
             std::string msg = TRANSLATE_ME("duplicate title name '%s'", title.c_str());
             throw std::invalid_argument(msg);
         }
+        _titles.push_back(std::move(title));
+    }
 
-        _title_to_index.emplace(title, i);
-        i++;
+    const size_t rows = _data.rows();
+    _columns.assign(cols * rows, MISSING_CELL);
+    for (size_t row_i = 0; row_i != rows; row_i++) {
+        const size_t row_cols = std::min(cols, _data.cols(row_i));
+        for (size_t col_i = 0; col_i != row_cols; col_i++) {
+            _columns[col_i * rows + row_i] = _data.span(row_i, col_i);
+        }
     }
 }
 
-const std::string& CsvMap::get(size_t row_i, const std::string& title_name) const
+ColumnHandle CsvMap::column(const std::string& title_name) const
 {
+    // callers mostly use already normalized names, so try it as is first
+    auto it = _title_to_index.find(title_name);
+    if (it == _title_to_index.end()) {
+        it = _title_to_index.find(_ci_strip(title_name));
+        if (it == _title_to_index.end()) {
+            return ColumnHandle{};
+        }
+    }
+    return ColumnHandle{it->second};
+}
 
-    if (row_i >= _data.size()) {
-        std::string msg = TRANSLATE_ME("row_index %zu was out of range %zu", row_i, _data.size());
+std::string_view CsvMap::cell(size_t row_i, ColumnHandle column) const
+{
+    if (row_i >= _data.rows()) {
+        std::string msg = TRANSLATE_ME("row_index %zu was out of range %zu", row_i, _data.rows());
         throw std::out_of_range(msg);
     }
 
-    std::string title = _ci_strip(title_name);
-
-    if (_title_to_index.count(title) == 0) {
-        std::string msg = TRANSLATE_ME("title name '%s' not found", title.c_str());
-        throw std::out_of_range{msg};
+    if (!column.valid() || column.index() >= _titles.size()) {
+        throw std::out_of_range(TRANSLATE_ME("column index was out of range %zu", _titles.size()));
     }
 
-    size_t col_i = _title_to_index.at(title);
-    if (col_i >= _data[row_i].size()) {
+    const CsvDocument::Span& span = _columns[column.index() * _data.rows() + row_i];
+    if (span.offset == MISSING_CELL.offset) {
         const char* err = "On line %zu: requested column %s (index %zu) where maximum is %zu";
-        throw std::out_of_range(TRANSLATE_ME(err, row_i + 1, title_name.c_str(), col_i + 1, _data[row_i].size()));
+        throw std::out_of_range(TRANSLATE_ME(
+            err, row_i + 1, _titles[column.index()].c_str(), column.index() + 1, _data.cols(row_i)));
+    }
+    return _data.view(span);
+}
+
+std::string CsvMap::get_strip(size_t row_i, ColumnHandle column) const
+{
+    return _ci_strip(cell(row_i, column));
+}
+
+std::string CsvMap::get(size_t row_i, const std::string& title_name) const
+{
+
+    if (row_i >= _data.rows()) {
+        std::string msg = TRANSLATE_ME("row_index %zu was out of range %zu", row_i, _data.rows());
+        throw std::out_of_range(msg);
+    }
+
+    ColumnHandle handle = column(title_name);
+    if (!handle) {
+        std::string msg = TRANSLATE_ME("title name '%s' not found", _ci_strip(title_name).c_str());
+        throw std::out_of_range{msg};
     }
-    return _data[row_i][col_i];
+
+    return get(row_i, handle);
 }
 
 std::string CsvMap::get_strip(size_t row_i, const std::string& title_name) const
@@ -95,17 +140,12 @@ std::string CsvMap::get_strip(size_t row_i, const std::string& title_name) const
 
 bool CsvMap::hasTitle(const std::string& title_name) const
 {
-    std::string title = _ci_strip(title_name);
-    return (_title_to_index.count(title) == 1);
+    return column(title_name).valid();
 }
 
 std::set<std::string> CsvMap::getTitles() const
 {
-    std::set<std::string> ret{};
-    for (auto i : _title_to_index) {
-        ret.emplace(i.first);
-    }
-    return ret;
+    return std::set<std::string>{_titles.begin(), _titles.end()};
 }
 
 std::string CsvMap::getCreateUser() const
@@ -187,20 +227,7 @@ bool hasApostrof(std::istream& i)
 }
 CsvMap CsvMap_from_istream(std::istream& in)
 {
-    std::vector<std::vector<std::string>> data;
-    cxxtools::CsvDeserializer                  deserializer(in);
-    char                                       delimiter = findDelimiter(in);
-    if (delimiter == '\x0') {
-        std::string msg = TRANSLATE_ME("Cannot detect the delimiter, use comma (,) semicolon (;) or tabulator");
-        log_error("%s\n", msg.c_str());
-        LOG_END;
-        throw std::invalid_argument(msg);
-    }
-    log_debug("Using delimiter '%c'", delimiter);
-    deserializer.delimiter(delimiter);
-    deserializer.readTitle(false);
-    deserializer.deserialize(data);
-    CsvMap cm{data};
+    CsvMap cm{CsvDocument::from_istream(in)};
     cm.deserialize();
     return cm;
 }
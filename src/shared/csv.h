@@ -28,34 +28,70 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 ///    buf << "RACK-01, rack,GR-01, GR-02,just my dc\n";
 ///    buf << "RACK-02, rack,GR-01, GR-02,just my rack\n";
 ///
-///    std::vector<std::vector<std::string> > data;
-///    cxxtools::CsvDeserializer deserializer(buf);
-///    deserializer.delimiter(',');
-///    deserializer.readTitle(false);
-///    deserializer.deserialize(data);
-///
-///    shared::CsvMap cm{data};
-///    cm.deserialize();
+///    shared::CsvMap cm = shared::CsvMap_from_istream(buf);
 ///
 ///    assert (cm.get(0, "nAMe") == "Name");
 ///    assert (cm.get(1, " name") == "RACK-01");
 
 #pragma once
 
+#include "shared/csv_document.h"
 #include <cstdint>
-#include <cxxtools/csvdeserializer.h>
-#include <map>
+#include <cxxtools/serializationinfo.h>
+#include <limits>
+#include <set>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 namespace shared {
 
+/// @class ColumnHandle
+///
+/// Column of a CsvMap resolved once, so reading the column on every row does not need to look the title up again
+class ColumnHandle
+{
+public:
+    /// Creates an invalid handle
+    ColumnHandle(void)
+        : _index{npos} {};
+
+    /// return if the column exists in the CsvMap it was resolved from
+    bool valid() const
+    {
+        return _index != npos;
+    }
+
+    explicit operator bool() const
+    {
+        return valid();
+    }
+
+    /// return index of the column, must be valid
+    size_t index() const
+    {
+        return _index;
+    }
+
+private:
+    friend class CsvMap;
+
+    explicit ColumnHandle(size_t index)
+        : _index{index} {};
+
+    static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+    size_t _index;
+};
+
 /// @class CsvMap
 ///
 /// Provide map-like interface to result of csv file
 ///
 /// This class does provide map-like interface to tabular data from csv file, so you can refer to columns using name of
-/// field
+/// field. Titles are normalized (see get_strip) once in deserialize, cells are indexed column by column, so reading
+/// a row through ColumnHandle is an O(1) lookup without allocation.
 class CsvMap
 {
 public:
@@ -65,22 +101,75 @@ public:
     /// Creates new CsvMap instance with data inside
     CsvMap(const Data& data)
         : _data{data}
-        , _title_to_index{} {};
+        , _titles{}
+        , _title_to_index{}
+        , _columns{}
+        , _create_mode{0} {};
+
+    /// Creates new CsvMap instance on top of tokenized csv file
+    CsvMap(CsvDocument&& data)
+        : _data{std::move(data)}
+        , _titles{}
+        , _title_to_index{}
+        , _columns{}
+        , _create_mode{0} {};
 
     /// Creates an empty CsvMap instance
     CsvMap(void)
         : _data{}
-        , _title_to_index{} {};
+        , _titles{}
+        , _title_to_index{}
+        , _columns{}
+        , _create_mode{0} {};
 
     /// deserialize provided data, inicialize map of row title to index
     ///
     /// @throws std::invalid_argument if csv contain multiple title with the same name
     void deserialize();
 
+    /// return the handle of column with the given title name, the handle is invalid if there is no such column
+    ColumnHandle column(const std::string& title_name) const;
+
+    /// return the handle of column on given index, col_i must be < cols()
+    ColumnHandle column_at(size_t col_i) const
+    {
+        return ColumnHandle{col_i};
+    }
+
+    /// return the normalized title of the column
+    const std::string& title(ColumnHandle column) const
+    {
+        return _titles.at(column.index());
+    }
+
+    /// return normalized titles in order of columns
+    const std::vector<std::string>& titles() const
+    {
+        return _titles;
+    }
+
+    /// return the content on row in the given column, valid as long as the CsvMap lives
+    ///
+    /// @throws std::out_of_range if row_i >= rows(), the column is invalid or it is missing on the row
+    std::string_view cell(size_t row_i, ColumnHandle column) const;
+
+    /// return the content on row in the given column
+    ///
+    /// @throws std::out_of_range if row_i >= rows(), the column is invalid or it is missing on the row
+    std::string get(size_t row_i, ColumnHandle column) const
+    {
+        return std::string{cell(row_i, column)};
+    }
+
+    /// return the content on row in the given column striped and in lower case
+    ///
+    /// @throws std::out_of_range if row_i >= rows(), the column is invalid or it is missing on the row
+    std::string get_strip(size_t row_i, ColumnHandle column) const;
+
     /// return the content on row with the given title name
     ///
     /// @throws std::out_of_range if row_i > data.size() or title_name is not known
-    const std::string& get(size_t row_i, const std::string& title_name) const;
+    std::string get(size_t row_i, const std::string& title_name) const;
 
     /// return the content on row with the given title name striped and in lower case
     ///
@@ -90,13 +179,13 @@ public:
     /// return number of rows
     size_t rows() const
     {
-        return _data.size();
+        return _data.rows();
     }
 
     /// return number of columns
     size_t cols() const
     {
-        return _data[0].size();
+        return _titles.size();
     }
 
     /**
@@ -120,10 +209,12 @@ public:
     void setCreateMode(uint32_t mode);
 
 private:
-    Data                          _data;
-    std::map<std::string, size_t> _title_to_index;
-    std::string                   _create_user, _update_user, _update_ts;
-    uint32_t                      _create_mode;
+    CsvDocument                             _data;
+    std::vector<std::string>                _titles; // normalized, index is the column
+    std::unordered_map<std::string, size_t> _title_to_index;
+    std::vector<CsvDocument::Span>          _columns; // column major: cell (row_i, col_i) is [col_i * rows() + row_i]
+    std::string                             _create_user, _update_user, _update_ts;
+    uint32_t                                _create_mode;
 };
 
 // TODO: does not belongs to csv, move somewhere else
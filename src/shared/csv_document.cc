@@ -0,0 +1,282 @@
+/*
+ *
+ * Copyright (C) 2015 - 2020 Eaton
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "shared/csv_document.h"
+#include <cstring>
+#include <fty_common.h>
+#include <fty_common_macros.h>
+#include <istream>
+#include <limits>
+#include <stdexcept>
+
+namespace shared {
+
+// cxxtools::CsvParser, which parsed the imports before, accepts both
+static bool isQuote(char c)
+{
+    return c == '"' || c == '\'';
+}
+
+CsvDocument::CsvDocument(std::string&& buffer, char delimiter)
+    : _buffer{std::move(buffer)}
+    , _cells{}
+    , _rows{0}
+    , _delimiter{delimiter}
+{
+    // spans are 32 bit to keep the index of big files small
+    if (_buffer.size() >= std::numeric_limits<uint32_t>::max()) {
+        throw std::invalid_argument(TRANSLATE_ME("Input is too big, %zu bytes", _buffer.size()));
+    }
+    tokenize();
+}
+
+CsvDocument::CsvDocument(const std::vector<std::vector<std::string>>& data)
+    : _buffer{}
+    , _cells{}
+    , _rows{0}
+    , _delimiter{','}
+{
+    size_t size  = 0;
+    size_t cells = 0;
+    for (const auto& row : data) {
+        for (const auto& cell : row) {
+            size += cell.size();
+        }
+        cells += row.size();
+    }
+    if (size >= std::numeric_limits<uint32_t>::max()) {
+        throw std::invalid_argument(TRANSLATE_ME("Input is too big, %zu bytes", size));
+    }
+    _buffer.reserve(size);
+    _cells.reserve(cells);
+    _rows.reserve(data.size() + 1);
+
+    for (const auto& row : data) {
+        for (const auto& cell : row) {
+            _cells.push_back(Span{uint32_t(_buffer.size()), uint32_t(cell.size())});
+            _buffer.append(cell);
+        }
+        _rows.push_back(uint32_t(_cells.size()));
+    }
+}
+
+void CsvDocument::tokenize()
+{
+    char*        buf = _buffer.data();
+    const size_t n   = _buffer.size();
+    size_t       r   = 0; // read position
+    size_t       w   = 0; // write position, differs from r only after an unescaped quote
+
+    // skip the UTF-8 BOM
+    if (n >= 3 && buf[0] == '\xef' && buf[1] == '\xbb' && buf[2] == '\xbf') {
+        r = w = 3;
+    }
+
+    // rough estimate so big files do not reallocate the index too often
+    _cells.reserve(n / 8);
+
+    const char delimiter = _delimiter;
+    while (r < n) {
+        for (;;) {
+            size_t start = w;
+            if (isQuote(buf[r])) {
+                const char quote = buf[r++];
+                for (;;) {
+                    if (r >= n) {
+                        throw std::invalid_argument(
+                            TRANSLATE_ME("On line %zu: quoted value is not terminated", _rows.size()));
+                    }
+                    char c = buf[r++];
+                    if (c == quote) {
+                        if (r < n && buf[r] == quote) {
+                            ++r;
+                        } else {
+                            break;
+                        }
+                    }
+                    buf[w++] = c;
+                }
+            }
+            // unquoted content (or whatever follows the closing quote) up to the end of the cell
+            size_t end = r;
+            while (end < n && buf[end] != delimiter && buf[end] != '\n' && buf[end] != '\r') {
+                ++end;
+            }
+            if (w != r) {
+                std::memmove(buf + w, buf + r, end - r);
+            }
+            w += end - r;
+            r = end;
+
+            _cells.push_back(Span{uint32_t(start), uint32_t(w - start)});
+            if (r < n && buf[r] == delimiter) {
+                ++r;
+                if (r == n) {
+                    // delimiter at the very end of input means one more empty cell
+                    _cells.push_back(Span{uint32_t(w), 0});
+                    break;
+                }
+                continue;
+            }
+            break;
+        }
+        // "\r\n", "\n" or "\r"
+        if (r < n && buf[r] == '\r') {
+            ++r;
+        }
+        if (r < n && buf[r] == '\n') {
+            ++r;
+        }
+        _rows.push_back(uint32_t(_cells.size()));
+    }
+}
+
+std::string CsvDocument::read_all(std::istream& in)
+{
+    std::string buffer;
+
+    // seekable streams (files, string streams) can tell the size upfront
+    auto pos = in.tellg();
+    if (pos != std::streampos(-1)) {
+        in.seekg(0, std::ios::end);
+        auto end = in.tellg();
+        in.seekg(pos);
+        if (end > pos) {
+            buffer.reserve(size_t(end - pos));
+        }
+    }
+
+    char chunk[64 * 1024];
+    while (in.read(chunk, sizeof(chunk)) || in.gcount() > 0) {
+        buffer.append(chunk, size_t(in.gcount()));
+    }
+    return buffer;
+}
+
+CsvDocument CsvDocument::from_istream(std::istream& in)
+{
+    std::string buffer    = read_all(in);
+    char        delimiter = findDelimiter(buffer);
+    if (delimiter == '\x0') {
+        std::string msg = TRANSLATE_ME("Cannot detect the delimiter, use comma (,) semicolon (;) or tabulator");
+        log_error("%s\n", msg.c_str());
+        throw std::invalid_argument(msg);
+    }
+    log_debug("Using delimiter '%c'", delimiter);
+    return CsvDocument{std::move(buffer), delimiter};
+}
+
+CsvRowReader::CsvRowReader(std::istream& in, size_t batch_size, bool repeat_title)
+    : _in{in}
+    , _batch_size{batch_size}
+    , _repeat_title{repeat_title}
+    , _pending{}
+    , _title{}
+    , _title_end{std::string::npos}
+    , _quote{'\x0'}
+    , _closing{false}
+    , _cell_start{true}
+    , _delimiter{'\x0'}
+{
+    // same amount of data findDelimiter looks at in whole documents
+    static const size_t DELIMITER_MAX_POS = 60;
+    std::string         line;
+    while (_pending.size() < DELIMITER_MAX_POS && std::getline(_in, line)) {
+        _pending.append(line);
+        _pending.push_back('\n');
+    }
+    _delimiter = findDelimiter(_pending, DELIMITER_MAX_POS);
+    scan(_pending, 0);
+}
+
+void CsvRowReader::scan(std::string_view text, size_t offset)
+{
+    for (size_t i = 0; i != text.size(); i++) {
+        const char c = text[i];
+        if (_quote != '\x0') {
+            if (_closing) {
+                _closing = false;
+                if (c == _quote) {
+                    // doubled quote is a quote inside the value
+                    continue;
+                }
+                _quote = '\x0';
+            } else {
+                _closing = c == _quote;
+                continue;
+            }
+        }
+        if (_cell_start && isQuote(c)) {
+            _quote      = c;
+            _cell_start = false;
+            continue;
+        }
+        _cell_start = c == _delimiter || c == '\n';
+        if (c == '\n' && _title_end == std::string::npos) {
+            _title_end = offset + i + 1;
+        }
+    }
+}
+
+bool CsvRowReader::read_line()
+{
+    std::string line;
+    if (!std::getline(_in, line)) {
+        return false;
+    }
+    line.push_back('\n');
+    scan(line, _pending.size());
+    _pending.append(line);
+    return true;
+}
+
+bool CsvRowReader::next(CsvDocument& rows)
+{
+    bool eof = false;
+    while (!eof && (_pending.size() < _batch_size || _quote != '\x0' ||
+                       (_repeat_title && _title_end == std::string::npos))) {
+        eof = !read_line();
+    }
+    // nothing but the repeated title is left
+    if (_pending.size() == _title.size()) {
+        return false;
+    }
+    if (_repeat_title && _title.empty() && _title_end != std::string::npos) {
+        _title = _pending.substr(0, _title_end);
+    }
+
+    // a row still open at the end of input is reported by the tokenizer
+    rows     = CsvDocument{std::move(_pending), _delimiter};
+    _pending = _title;
+    return true;
+}
+
+char findDelimiter(std::string_view buffer, std::size_t max_pos)
+{
+    for (std::size_t pos = 0; pos != max_pos && pos != buffer.size(); pos++) {
+        char ret = buffer[pos];
+        if (ret == ',' || ret == ';' || ret == '\t') {
+            return ret;
+        }
+    }
+    return '\x0';
+}
+
+} // namespace shared
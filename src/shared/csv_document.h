@@ -0,0 +1,176 @@
+/*
+Copyright (C) 2015 - 2020 Eaton
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+/// \file csv_document.h
+/// \brief Single pass CSV tokenizer
+///
+/// The whole input is read into one buffer and split into cells in one pass. Cells are kept as (offset, size) spans
+/// into that buffer, so tokenizing does not allocate per cell. Quoted cells are unescaped in place: the unescaped
+/// content is never longer than the raw one, so it is written back over the already consumed bytes.
+///
+/// Supported syntax is the one our csv files use
+///  * delimiter is the first ',', ';' or tab found in the first 60 bytes (see shared::findDelimiter)
+///  * optional UTF-8 BOM at the beginning is skipped
+///  * cell starting with '"' or '\'' is quoted by that character, the character doubled inside is an escaped quote,
+///    delimiters and new lines are part of the cell, the same rules cxxtools::CsvParser has
+///  * rows are terminated by "\n", "\r\n" or "\r", the terminator of the last row is optional
+
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace shared {
+
+/// @class CsvDocument
+///
+/// Tokenized csv file, cells are accessible as std::string_view which are valid as long as the document lives
+class CsvDocument
+{
+public:
+    /// position of one cell in the document buffer
+    struct Span
+    {
+        uint32_t offset;
+        uint32_t size;
+    };
+
+public:
+    /// Creates an empty document
+    CsvDocument(void)
+        : _buffer{}
+        , _cells{}
+        , _rows{0}
+        , _delimiter{'\x0'} {};
+
+    /// Creates a document from already split data, used for data which do not come from a csv file
+    explicit CsvDocument(const std::vector<std::vector<std::string>>& data);
+
+    /// Tokenize the buffer using given delimiter
+    ///
+    /// @throws std::invalid_argument if the buffer is too big or has unterminated quoted cell
+    CsvDocument(std::string&& buffer, char delimiter);
+
+    /// Read the whole stream and tokenize it, delimiter is autodetected
+    ///
+    /// @throws std::invalid_argument if delimiter was not detected or the content is malformed
+    static CsvDocument from_istream(std::istream& in);
+
+    /// Read whole content of the stream
+    static std::string read_all(std::istream& in);
+
+    /// return number of rows
+    size_t rows() const
+    {
+        return _rows.size() - 1;
+    }
+
+    /// return number of cells on the given row
+    size_t cols(size_t row_i) const
+    {
+        return _rows[row_i + 1] - _rows[row_i];
+    }
+
+    /// return the position of the cell, row_i and col_i must be in range
+    Span span(size_t row_i, size_t col_i) const
+    {
+        return _cells[_rows[row_i] + col_i];
+    }
+
+    /// return the content of the span
+    std::string_view view(Span span) const
+    {
+        return std::string_view{_buffer.data() + span.offset, span.size};
+    }
+
+    /// return the content of the cell, row_i and col_i must be in range
+    std::string_view cell(size_t row_i, size_t col_i) const
+    {
+        return view(span(row_i, col_i));
+    }
+
+    char delimiter() const
+    {
+        return _delimiter;
+    }
+
+private:
+    void tokenize();
+
+    std::string           _buffer;
+    std::vector<Span>     _cells;
+    std::vector<uint32_t> _rows; // index of the first cell of each row, last item is a sentinel
+    char                  _delimiter;
+};
+
+/// @class CsvRowReader
+///
+/// Reads csv rows from the stream in batches of bounded size, so big files can be processed without holding
+/// the whole content in memory. Each batch contains whole rows only, quoted cells spanning lines are kept together.
+class CsvRowReader
+{
+public:
+    /// Reads the beginning of the stream to detect the delimiter
+    ///
+    /// @param[in] repeat_title - every batch starts with the title row of the file, so it is a csv file on its own
+    explicit CsvRowReader(std::istream& in, size_t batch_size = 64 * 1024, bool repeat_title = false);
+
+    /// return detected delimiter or '\x0' if none was found
+    char delimiter() const
+    {
+        return _delimiter;
+    }
+
+    /// Tokenize next batch of rows into the document
+    ///
+    /// @return false if there are no more rows
+    /// @throws std::invalid_argument if the content is malformed
+    bool next(CsvDocument& rows);
+
+private:
+    /// append one line to the pending buffer, return false on end of input
+    bool read_line();
+
+    /// follow quoting of the text appended to the pending buffer at given offset
+    void scan(std::string_view text, size_t offset);
+
+    std::istream& _in;
+    size_t        _batch_size;
+    bool          _repeat_title;
+    std::string   _pending;    // lines read but not returned yet
+    std::string   _title;      // title row put in front of every batch after the first one
+    size_t        _title_end;  // end of the title row in the first batch, npos until it is read
+    char          _quote;      // quote of the value still open at the end of _pending, the row continues
+    bool          _closing;    // the last character scanned was _quote inside the value, closing or escaping it
+    bool          _cell_start; // the next character scanned starts a cell
+    char          _delimiter;
+};
+
+/**
+ * \brief find the delimiter used in csv content
+ *
+ * Buffer counterpart of findDelimiter(std::istream&, std::size_t)
+ *
+ * \return ';' or '\t' or ',' or '\x0' if nothing found in first \max_pos bytes
+ */
+char findDelimiter(std::string_view buffer, std::size_t max_pos = 60);
+
+} // namespace shared
@@ -0,0 +1,94 @@
+/*
+Copyright (C) 2015 - 2020 Eaton
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "shared/csv_writer.h"
+#include <charconv>
+#include <ostream>
+
+namespace shared {
+
+CsvWriter::CsvWriter(std::ostream& out, size_t flush_size, char delimiter)
+    : _out{out}
+    , _buffer{}
+    , _flush_size{flush_size}
+    , _written{0}
+    , _delimiter{delimiter}
+    , _row_start{true}
+{
+    // room for the last row which crosses the flush size
+    _buffer.reserve(flush_size + flush_size / 4);
+}
+
+CsvWriter::~CsvWriter()
+{
+    try {
+        flush();
+    } catch (...) {
+    }
+}
+
+void CsvWriter::add(std::string_view cell)
+{
+    if (!_row_start) {
+        _buffer.push_back(_delimiter);
+    }
+    _row_start = false;
+
+    const char special[] = {_delimiter, '"', '\n', '\r'};
+    if (cell.find_first_of(std::string_view{special, sizeof(special)}) == std::string_view::npos) {
+        _buffer.append(cell.data(), cell.size());
+        return;
+    }
+
+    _buffer.push_back('"');
+    for (char ch : cell) {
+        if (ch == '"') {
+            _buffer.push_back('"');
+        }
+        _buffer.push_back(ch);
+    }
+    _buffer.push_back('"');
+}
+
+void CsvWriter::add(uint32_t number)
+{
+    char buf[16];
+    auto res = std::to_chars(buf, buf + sizeof(buf), number);
+    add(std::string_view{buf, size_t(res.ptr - buf)});
+}
+
+void CsvWriter::endRow()
+{
+    _buffer.push_back('\n');
+    _row_start = true;
+    if (_buffer.size() >= _flush_size) {
+        flush();
+    }
+}
+
+void CsvWriter::flush()
+{
+    if (!_buffer.empty()) {
+        _out.write(_buffer.data(), std::streamsize(_buffer.size()));
+        _written += _buffer.size();
+        _buffer.clear();
+    }
+    _out.flush();
+}
+
+} // namespace shared
@@ -0,0 +1,81 @@
+/*
+Copyright (C) 2015 - 2020 Eaton
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+/// \file csv_writer.h
+/// \brief Streaming CSV writer
+///
+/// Cells are appended to one buffer which is reused for the whole output and handed to the stream once it grows
+/// over the flush size, so a row costs no allocation once the buffer has grown. The output is the one
+/// cxxtools::CsvSerializer gives
+///  * cells are separated by the delimiter, rows are terminated by "\n"
+///  * cell containing the delimiter, '"', '\n' or '\r' is quoted and '"' inside is doubled, other cells are written
+///    as they are
+
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+namespace shared {
+
+/// @class CsvWriter
+class CsvWriter
+{
+public:
+    /// Creates writer, nothing is written until flush size is reached or flush() is called
+    ///
+    /// @param[in] out        - stream the csv goes to
+    /// @param[in] flush_size - buffered bytes which are written and flushed to the stream at once
+    /// @param[in] delimiter  - cell delimiter
+    explicit CsvWriter(std::ostream& out, size_t flush_size = 64 * 1024, char delimiter = ',');
+
+    CsvWriter(const CsvWriter&) = delete;
+    CsvWriter& operator=(const CsvWriter&) = delete;
+
+    /// Writes what is left in the buffer, errors of the stream are not reported
+    ~CsvWriter();
+
+    /// Appends one cell to the current row
+    void add(std::string_view cell);
+
+    void add(uint32_t number);
+
+    /// Terminates the current row, the buffer goes to the stream if it is over the flush size
+    void endRow();
+
+    /// Writes the buffer to the stream and flushes the stream, so a streamed reply sends it at once
+    void flush();
+
+    /// return number of bytes written so far, buffered ones included
+    size_t written() const
+    {
+        return _written + _buffer.size();
+    }
+
+private:
+    std::ostream& _out;
+    std::string   _buffer;
+    size_t        _flush_size;
+    size_t        _written;
+    char          _delimiter;
+    bool          _row_start;
+};
+
+} // namespace shared
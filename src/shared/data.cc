@@ -31,12 +31,17 @@
 
 #include "shared/data.h"
 #include "db/asset_general.h"
+#include "shared/sql_in.h"
 #include "shared/utils_json.h"
 #include <algorithm>
 #include <fty_common.h>
 #include <fty_common_db_dbpath.h>
 #include <fty_common_macros.h>
 #include <fty_common_rest.h>
+#include <functional>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
 
 static std::vector<std::tuple<a_elmnt_id_t, std::string, std::string, std::string>> s_get_parents(
     tntdb::Connection& conn, a_elmnt_id_t id)
@@ -91,7 +96,22 @@ db_reply<db_web_element_t> asset_manager::get_item1(uint32_t id)
     try {
         tntdb::Connection conn = tntdb::connect(DBConn::url);
         log_debug("connection was successful");
+        return get_item1(conn, id);
+    } catch (const std::exception& e) {
+        ret.status     = 0;
+        ret.errtype    = DB_ERR;
+        ret.errsubtype = DB_ERROR_INTERNAL;
+        ret.msg        = JSONIFY(e.what());
+        LOG_END_ABNORMAL(e);
+        return ret;
+    }
+}
 
+db_reply<db_web_element_t> asset_manager::get_item1(tntdb::Connection& conn, uint32_t id)
+{
+    db_reply<db_web_element_t> ret;
+
+    try {
         auto basic_ret = DBAssets::select_asset_element_web_byId(conn, id);
         log_debug("1/5 basic select is done");
 
@@ -286,7 +306,7 @@ db_reply_t asset_manager::delete_item(uint32_t id, db_a_elmnt_t& element_info)
             case persist::asset_type::DEVICE: {
                 if (basic_info.item.status == "active") {
                     // we need device JSON in order to delete active device
-                    std::string asset_json = getJsonAsset(NULL, id);
+                    std::string asset_json = getJsonAssets(conn, NULL, {id})[id];
                     ret                    = persist::delete_device(conn, id, asset_json);
                 } else {
                     ret = persist::delete_device(conn, id);
@@ -333,97 +353,265 @@ struct CheckException : public std::runtime_error
 struct ElementInfo
 {
     db_a_elmnt_t          el;
-    std::vector<uint32_t> links;
+    std::vector<uint32_t> links; // destinations of power links from the asset
 };
 
-static void checkAndAddInfo(std::vector<ElementInfo>& ids, const ElementInfo& item)
+// why an asset can't be deleted while another one stays
+enum class Blocker
 {
-    auto it = std::find_if(ids.begin(), ids.end(), [&](const ElementInfo& check) {
-        return check.el.id == item.el.id;
-    });
+    CHILD,
+    LINK,
+    LOGICAL_ASSET
+};
 
-    if (it == ids.end()) {
-        // disable deleting RC0
-        if (RC0_INAME == item.el.name) {
-            log_debug("Prevented deleting RC-0");
-            throw CheckException(item.el.id, "Prevented deleting RC-0");
-        }
+// children of every asset which has any
+typedef std::unordered_map<uint32_t, std::vector<uint32_t>> children_map_t;
 
-        ids.push_back(item);
+// requested asset -> requested assets which can't be deleted without it
+typedef std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, Blocker>>> dependents_map_t;
+
+static CheckException blockedBy(uint32_t id, Blocker blocker)
+{
+    switch (blocker) {
+        case Blocker::CHILD:
+            return CheckException(id, TRANSLATE_ME("can't delete the asset because it has at least one child"));
+        case Blocker::LINK:
+            return CheckException(id, TRANSLATE_ME("can't delete the asset because it is linked to others"));
+        case Blocker::LOGICAL_ASSET:
+            break;
     }
+    return CheckException(id, TRANSLATE_ME("a logical_asset (sensor) refers to it"), DB_ERR, DB_ERROR_DELETEFAIL);
 }
 
-static void collectChildren(tntdb::Connection& conn, uint32_t id, std::vector<ElementInfo>& ids)
+static db_reply_t checkFailure(const CheckException& e)
 {
-    // Now corresponding functions to collect child items/filter by parent.
-    // TODO: Add to fty-common-db
-    DBAssets::select_assets_cb(conn, [&](const tntdb::Row& row) {
-        if (id == static_cast<uint32_t>(row["id_parent"].getInt())) {
-            ElementInfo item;
-
-            row["id"].get(item.el.id);
-            row["id_type"].get(item.el.type_id);
-            row["id_subtype"].get(item.el.subtype_id);
-            row["name"].get(item.el.name);
-            row["id_parent"].get(item.el.parent_id);
-
-            collectChildren(conn, item.el.id, ids);
-            checkAndAddInfo(ids, item);
-        }
-    });
+    db_reply_t answ = db_reply_new();
+    answ.status     = 0;
+    answ.errtype    = e.errType;
+    answ.errsubtype = e.errSubType;
+    answ.msg        = e.what();
+    log_warning("%s", e.what());
+    return answ;
 }
 
-static std::vector<uint32_t> selectAnyLinks(tntdb::Connection& conn, const ElementInfo& item)
+/*
+ * \brief Reads basic info and power links of all assets at once, missing assets are left out
+ */
+static std::unordered_map<uint32_t, ElementInfo> selectElements(
+    tntdb::Connection& conn, const std::vector<uint32_t>& ids)
 {
-    std::vector<uint32_t> links;
-    try {
-        tntdb::Statement st = conn.prepareCached(
+    std::unordered_map<uint32_t, ElementInfo> elements;
+    for (const auto& in : shared::sql_in_lists(ids)) {
+        tntdb::Statement st = conn.prepare(
             " SELECT"
-            "   id_asset_device_dest"
+            "   id_asset_element, name, id_parent, status, id_type, id_subtype"
+            " FROM"
+            "   t_bios_asset_element"
+            " WHERE"
+            "   id_asset_element IN (" + in + ")");
+
+        for (const auto& row : st.select()) {
+            ElementInfo info;
+            info.el.id = row.getUnsigned32(0);
+            row[1].get(info.el.name);
+            row[2].get(info.el.parent_id); // stays 0 on NULL
+            row[3].get(info.el.status);
+            row[4].get(info.el.type_id);
+            row[5].get(info.el.subtype_id);
+            elements[info.el.id] = std::move(info);
+        }
+    }
+
+    for (const auto& in : shared::sql_in_lists(ids)) {
+        tntdb::Statement st = conn.prepare(
+            " SELECT"
+            "   id_asset_device_src, id_asset_device_dest"
             " FROM"
             "   t_bios_asset_link"
             " WHERE"
-            "   id_asset_device_src = :src");
+            "   id_asset_device_src IN (" + in + ")");
 
-        auto result = st.set("src", item.el.id).select();
-        for (const auto& row : result) {
-            links.push_back(row.getUnsigned32("id_asset_device_dest"));
+        for (const auto& row : st.select()) {
+            auto it = elements.find(row.getUnsigned32(0));
+            if (it != elements.end()) {
+                it->second.links.push_back(row.getUnsigned32(1));
+            }
         }
-    } catch (const std::exception& e) {
-        throw CheckException(item.el.id, e.what(), DB_ERR, DB_ERROR_INTERNAL);
     }
-    return links;
+    return elements;
 }
 
-static db_reply_t deleteAsset(tntdb::Connection& conn, const ElementInfo& item)
+/*
+ * \brief Reads the parent of every asset at once, so a subtree of any size is collected without further queries
+ */
+static children_map_t selectChildrenMap(tntdb::Connection& conn)
 {
-    if (DBAssets::count_keytag(conn, "logical_asset", item.el.name) > 0) {
-        throw CheckException(
-            item.el.id, TRANSLATE_ME("a logical_asset (sensor) refers to it"), DB_ERR, DB_ERROR_DELETEFAIL);
+    children_map_t children;
+
+    tntdb::Statement st = conn.prepareCached(
+        " SELECT"
+        "   id_asset_element, id_parent"
+        " FROM"
+        "   t_bios_asset_element"
+        " WHERE"
+        "   id_parent IS NOT NULL");
+
+    for (const auto& row : st.select()) {
+        children[row.getUnsigned32(1)].push_back(row.getUnsigned32(0));
     }
+    return children;
+}
 
-    try {
-        switch (item.el.type_id) {
-            case persist::asset_type::DATACENTER:
-            case persist::asset_type::ROW:
-            case persist::asset_type::ROOM:
-            case persist::asset_type::RACK:
-                // DBAssetsDelete::delete_asset_links_to(conn, item.id);
-                return persist::delete_dc_room_row_rack(conn, item.el.id);
-            case persist::asset_type::GROUP:
-                return persist::delete_group(conn, item.el.id);
-            case persist::asset_type::DEVICE:
-                if (item.el.status == "active") {
-                    // we need device JSON in order to delete active device
-                    std::string asset_json = getJsonAsset(nullptr, item.el.id);
-                    return persist::delete_device(conn, item.el.id, asset_json);
+/*
+ * \brief Reads which assets refer to others as their logical_asset, referred name -> referring assets
+ */
+static std::unordered_map<std::string, std::vector<uint32_t>> selectLogicalAssets(tntdb::Connection& conn)
+{
+    std::unordered_map<std::string, std::vector<uint32_t>> referrers;
+
+    tntdb::Statement st = conn.prepareCached(
+        " SELECT"
+        "   id_asset_element, value"
+        " FROM"
+        "   t_bios_asset_ext_attributes"
+        " WHERE"
+        "   keytag = 'logical_asset'");
+
+    for (const auto& row : st.select()) {
+        std::string name;
+        row[1].get(name);
+        referrers[name].push_back(row.getUnsigned32(0));
+    }
+    return referrers;
+}
+
+static unsigned countDatacenters(tntdb::Connection& conn)
+{
+    tntdb::Statement st = conn.prepareCached(
+        " SELECT COUNT(id_asset_element)"
+        " FROM"
+        "   t_bios_asset_element"
+        " WHERE"
+        "   id_type = (select id_asset_element_type from t_bios_asset_element_type where name = 'datacenter')");
+
+    return st.selectValue().getUnsigned();
+}
+
+/*
+ * \brief Collects ids of all assets under the asset, each of them once
+ */
+static void collectChildren(const children_map_t& children, uint32_t id, std::vector<uint32_t>& ids)
+{
+    std::unordered_set<uint32_t> seen{id};
+    std::vector<uint32_t>        stack{id};
+    while (!stack.empty()) {
+        auto it = children.find(stack.back());
+        stack.pop_back();
+        if (it == children.end()) {
+            continue;
+        }
+        for (uint32_t child : it->second) {
+            if (seen.insert(child).second) {
+                ids.push_back(child);
+                stack.push_back(child);
+            }
+        }
+    }
+}
+
+/*
+ * \brief Fails every valid asset which needs a failed one deleted first, and the ones which need those, ...
+ */
+static void failDependents(const dependents_map_t& dependents, std::vector<uint32_t> failed,
+    std::unordered_set<uint32_t>& valid, std::vector<std::pair<uint32_t, db_reply_t>>& ret)
+{
+    while (!failed.empty()) {
+        auto it = dependents.find(failed.back());
+        failed.pop_back();
+        if (it == dependents.end()) {
+            continue;
+        }
+        for (const auto& dependent : it->second) {
+            if (valid.erase(dependent.first)) {
+                ret.push_back({dependent.first, checkFailure(blockedBy(dependent.first, dependent.second))});
+                failed.push_back(dependent.first);
+            }
+        }
+    }
+}
+
+/*
+ * \brief Orders valid assets into levels, an asset comes after all the ones it needs deleted first
+ *
+ * Power links may go both ways and logical_asset references may make a cycle too, assets of such cycle can go in
+ * any order as their links and ext attributes are removed with them. They are put last, deepest first.
+ */
+static std::vector<std::vector<uint32_t>> orderDeletion(const std::vector<uint32_t>& candidates,
+    const std::unordered_set<uint32_t>& valid, const dependents_map_t& dependents,
+    const std::unordered_map<uint32_t, ElementInfo>& elements)
+{
+    // number of valid assets which must be deleted before the asset
+    std::unordered_map<uint32_t, size_t> waiting;
+    for (uint32_t id : candidates) {
+        if (valid.count(id)) {
+            waiting[id];
+        }
+    }
+    for (const auto& it : dependents) {
+        if (valid.count(it.first)) {
+            for (const auto& dependent : it.second) {
+                if (valid.count(dependent.first)) {
+                    waiting[dependent.first]++;
                 }
-                return persist::delete_device(conn, item.el.id);
+            }
+        }
+    }
+
+    std::vector<std::vector<uint32_t>> levels;
+    std::vector<uint32_t>              level;
+    for (uint32_t id : candidates) {
+        if (valid.count(id) && waiting[id] == 0) {
+            level.push_back(id);
+        }
+    }
+    size_t ordered = 0;
+    while (!level.empty()) {
+        std::vector<uint32_t> next;
+        for (uint32_t id : level) {
+            auto it = dependents.find(id);
+            if (it == dependents.end()) {
+                continue;
+            }
+            for (const auto& dependent : it->second) {
+                if (valid.count(dependent.first) && --waiting[dependent.first] == 0) {
+                    next.push_back(dependent.first);
+                }
+            }
+        }
+        ordered += level.size();
+        levels.push_back(std::move(level));
+        level = std::move(next);
+    }
+
+    if (ordered != valid.size()) {
+        log_warning("%zu assets refer to each other, they are deleted last", valid.size() - ordered);
+        // children still must go before their parents, one level per depth
+        std::map<size_t, std::vector<uint32_t>, std::greater<size_t>> by_depth;
+        for (uint32_t id : candidates) {
+            if (!valid.count(id) || waiting[id] == 0) {
+                continue;
+            }
+            size_t depth = 0;
+            for (auto it = elements.find(id); it != elements.end() && depth <= elements.size(); depth++) {
+                it = elements.find(it->second.el.parent_id);
+            }
+            by_depth[depth].push_back(id);
+        }
+        for (auto& it : by_depth) {
+            levels.push_back(std::move(it.second));
         }
-        throw CheckException(item.el.id, TRANSLATE_ME("unknown type"), DB_ERR, DB_ERROR_INTERNAL);
-    } catch (const std::exception& e) {
-        throw CheckException(item.el.id, e.what(), DB_ERR, DB_ERROR_DELETEFAIL);
     }
+    return levels;
 }
 
 std::vector<std::pair<uint32_t, db_reply_t>> asset_manager::delete_item(
@@ -432,124 +620,159 @@ std::vector<std::pair<uint32_t, db_reply_t>> asset_manager::delete_item(
     std::vector<std::pair<uint32_t, db_reply_t>> ret;
     tntdb::Connection                            conn = tntdb::connect(DBConn::url);
 
-    // collect ids recursively
-    std::vector<ElementInfo> toDel;
-    for (uint32_t id : ids) {
-        db_reply<db_web_basic_element_t> basic_info = DBAssets::select_asset_element_web_byId(conn, id);
+    // 1. the whole set is validated in memory, everything needed is read at once
+    std::unordered_map<uint32_t, ElementInfo>              elements;
+    children_map_t                                         children_map;
+    std::unordered_map<std::string, std::vector<uint32_t>> referrers;
+    unsigned                                               datacenters = 0;
+    try {
+        elements     = selectElements(conn, ids);
+        children_map = selectChildrenMap(conn);
+        referrers    = selectLogicalAssets(conn);
+        if (persist::keep_last_datacenter()) {
+            datacenters = countDatacenters(conn);
+        }
+    } catch (const std::exception& e) {
+        for (uint32_t id : ids) {
+            ret.push_back({id, checkFailure(CheckException(id, e.what(), DB_ERR, DB_ERROR_INTERNAL))});
+        }
+        return ret;
+    }
 
-        if (basic_info.status == 0) {
+    // assets requested together may contain, link and refer to each other
+    std::unordered_set<uint32_t> requested(ids.begin(), ids.end());
+
+    std::vector<uint32_t>        candidates; // passed the checks, in order of request
+    std::unordered_set<uint32_t> valid;      // still to be deleted
+    std::unordered_set<uint32_t> seen;
+    std::vector<uint32_t>        failed;
+    dependents_map_t             dependents;
+    for (uint32_t id : ids) {
+        if (!seen.insert(id).second) {
+            continue;
+        }
+        auto found = elements.find(id);
+        if (found == elements.end()) {
             db_reply_t answ = db_reply_new();
-            answ.status     = basic_info.status;
+            answ.status     = 0;
             answ.errtype    = DB_ERR;
             answ.errsubtype = DB_ERROR_NOTFOUND;
             answ.msg        = TRANSLATE_ME("problem with selecting basic info");
             ret.push_back({id, answ});
-        } else {
-            try {
-                ElementInfo info;
-                // here we are only if everything was ok
-                info.el.id         = id;
-                info.el.type_id    = basic_info.item.type_id;
-                info.el.subtype_id = basic_info.item.subtype_id;
-                info.el.name       = basic_info.item.name;
-                info.el.parent_id  = basic_info.item.parent_id;
-
-                element_info.push_back(info.el);
-
-                std::vector<ElementInfo> children;
-                collectChildren(conn, id, children);
-                for (uint32_t existsId : ids) {
-                    children.erase(
-                        std::remove_if(
-                            children.begin(), children.end(),
-                            [&](const ElementInfo& item) {
-                                return item.el.id == existsId;
-                            }),
-                        children.end());
-                }
+            continue;
+        }
+        const ElementInfo& info = found->second;
+        element_info.push_back(info.el);
 
-                auto links = selectAnyLinks(conn, info);
-                info.links = links;
+        try {
+            // disable deleting RC0
+            if (RC0_INAME == info.el.name) {
+                log_debug("Prevented deleting RC-0");
+                throw CheckException(id, "Prevented deleting RC-0");
+            }
 
-                checkAndAddInfo(toDel, info);
+            switch (info.el.type_id) {
+                case persist::asset_type::DATACENTER:
+                case persist::asset_type::ROW:
+                case persist::asset_type::ROOM:
+                case persist::asset_type::RACK:
+                case persist::asset_type::GROUP:
+                case persist::asset_type::DEVICE:
+                    break;
+                default:
+                    throw CheckException(id, TRANSLATE_ME("unknown type"), DB_ERR, DB_ERROR_INTERNAL);
+            }
 
-                if (!children.empty()) {
-                    throw CheckException(id, TRANSLATE_ME("can't delete the asset because it has at least one child"));
+            std::vector<uint32_t> children;
+            collectChildren(children_map, id, children);
+            for (uint32_t child : children) {
+                if (!requested.count(child)) {
+                    throw blockedBy(id, Blocker::CHILD);
                 }
-
-                for (uint32_t existsId : ids) {
-                    links.erase(std::remove(links.begin(), links.end(), existsId), links.end());
+            }
+            for (uint32_t link : info.links) {
+                if (!requested.count(link)) {
+                    throw blockedBy(id, Blocker::LINK);
                 }
-
-                if (!links.empty()) {
-                    throw CheckException(id, TRANSLATE_ME("can't delete the asset because it is linked to others"));
+            }
+            auto referring = referrers.find(info.el.name);
+            if (referring != referrers.end()) {
+                for (uint32_t sensor : referring->second) {
+                    if (sensor != id && !requested.count(sensor)) {
+                        throw blockedBy(id, Blocker::LOGICAL_ASSET);
+                    }
                 }
+            }
 
-            } catch (const CheckException& e) {
-                db_reply_t answ = db_reply_new();
-                answ.status     = 0;
-                answ.errtype    = e.errType;
-                answ.errsubtype = e.errSubType;
-                answ.msg        = e.what();
-                log_warning("%s", e.what());
-                LOG_END;
-                ret.push_back({id, answ});
+            // requested children, link destinations and sensors go first, the asset stays if any of them does
+            auto direct = children_map.find(id);
+            if (direct != children_map.end()) {
+                for (uint32_t child : direct->second) {
+                    dependents[child].push_back({id, Blocker::CHILD});
+                }
+            }
+            for (uint32_t link : info.links) {
+                dependents[link].push_back({id, Blocker::LINK});
+            }
+            if (referring != referrers.end()) {
+                for (uint32_t sensor : referring->second) {
+                    if (sensor != id) {
+                        dependents[sensor].push_back({id, Blocker::LOGICAL_ASSET});
+                    }
+                }
             }
+
+            candidates.push_back(id);
+            valid.insert(id);
+        } catch (const CheckException& e) {
+            ret.push_back({id, checkFailure(e)});
+            failed.push_back(id);
         }
     }
-
-    auto isLinked = [&](const ElementInfo& item, const ElementInfo& parent) {
-        auto isLLinked = std::find(item.links.begin(), item.links.end(), parent.el.id);
-        if (isLLinked != item.links.end()) {
-            return false;
+    failDependents(dependents, failed, valid, ret);
+
+    // Don't allow the deletion of the last datacenter (unless overriden), the last one in order of request stays
+    if (persist::keep_last_datacenter()) {
+        unsigned deleted = 0;
+        uint32_t last    = 0;
+        for (uint32_t id : candidates) {
+            if (valid.count(id) && elements.at(id).el.type_id == persist::asset_type::DATACENTER) {
+                deleted++;
+                last = id;
+            }
         }
-
-        auto isPLinked = std::find(parent.links.begin(), parent.links.end(), item.el.id);
-        if (isPLinked != parent.links.end()) {
-            return true;
+        if (deleted != 0 && deleted >= datacenters) {
+            valid.erase(last);
+            ret.push_back({last, checkFailure(CheckException(last,
+                                     TRANSLATE_ME("will not allow last datacenter to be deleted"), DB_ERR,
+                                     DB_ERROR_DELETEFAIL))});
+            failDependents(dependents, {last}, valid, ret);
         }
-        return false;
-    };
+    }
 
-    auto isAnyParent = [&](const ElementInfo& item, const ElementInfo& parent) {
-        auto p = parent;
-        while (true) {
-            if (item.el.parent_id == p.el.id) {
-                return true;
-            }
+    // 2. children, link destinations and sensors before the assets which need them gone
+    auto levels = orderDeletion(candidates, valid, dependents, elements);
 
-            auto found = std::find_if(toDel.begin(), toDel.end(), [&](const ElementInfo& it) {
-                return it.el.id == p.el.parent_id;
-            });
-            if (found == toDel.end()) {
-                return false;
+    // active devices need their json to be deactivated, all of them are rendered at once before deleting
+    std::vector<int64_t> active;
+    for (const auto& level : levels) {
+        for (uint32_t id : level) {
+            const auto& el = elements.at(id).el;
+            if (el.type_id == persist::asset_type::DEVICE && el.status == "active") {
+                active.push_back(id);
             }
-            p = *found;
         }
-    };
-
-    std::sort(toDel.begin(), toDel.end(), [&](const ElementInfo& l, const ElementInfo& r) {
-        return isAnyParent(l, r) || isLinked(l, r);
-    });
-
-    for (const auto& item : toDel) {
-        try {
-            auto it = std::find_if(ret.begin(), ret.end(), [&](const std::pair<uint32_t, db_reply_t>& pair) {
-                return pair.first == item.el.id;
-            });
+    }
+    std::map<int64_t, std::string> active_jsons;
+    if (!active.empty()) {
+        active_jsons = getJsonAssets(conn, nullptr, active);
+    }
 
-            if (it == ret.end() || it->second.status != 0) {
-                ret.push_back({item.el.id, deleteAsset(conn, item)});
-            }
-        } catch (const CheckException& e) {
-            db_reply_t answ = db_reply_new();
-            answ.status     = 0;
-            answ.errtype    = e.errType;
-            answ.errsubtype = e.errSubType;
-            answ.msg        = e.what();
-            log_warning("%s", e.what());
-            LOG_END;
-            ret.push_back({item.el.id, answ});
+    // 3. one transaction for all of them
+    auto replies = persist::delete_assets(conn, levels, active_jsons);
+    for (const auto& level : levels) {
+        for (uint32_t id : level) {
+            ret.push_back({id, replies[id]});
         }
     }
 
@@ -30,12 +30,14 @@
 #include <fty_common_db_asset.h>
 #include <map>
 #include <string>
+#include <tntdb/connection.h>
 
 class asset_manager
 {
 public:
     // new functionality
     db_reply<db_web_element_t>                get_item1(uint32_t id);
+    db_reply<db_web_element_t>                get_item1(tntdb::Connection& conn, uint32_t id);
     db_reply<std::map<uint32_t, std::string>> get_items1(const std::string& typeName, const std::string& subtypeName);
 
     // to support old style
@@ -0,0 +1,125 @@
+/*
+Copyright (C) 2015 - 2020 Eaton
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "shared/ext_attribute.h"
+
+namespace shared {
+
+static const ExtAttributeKey OTHER{ExtAttributeKind::Other, {}};
+
+/*
+ * \brief Length of the digits key starts with
+ */
+static size_t s_digits(std::string_view key) noexcept
+{
+    size_t i = 0;
+    while (i != key.size() && key[i] >= '0' && key[i] <= '9') {
+        ++i;
+    }
+    return i;
+}
+
+/*
+ * \brief Classifies "<prefix>.<digits>" key
+ */
+static ExtAttributeKey s_numbered(std::string_view key, std::string_view prefix, ExtAttributeKind kind) noexcept
+{
+    if (key.size() <= prefix.size() + 1 || key.compare(0, prefix.size(), prefix) != 0 || key[prefix.size()] != '.') {
+        return OTHER;
+    }
+    std::string_view number = key.substr(prefix.size() + 1);
+    if (s_digits(number) != number.size()) {
+        return OTHER;
+    }
+    return {kind, number};
+}
+
+/*
+ * \brief Classifies "outlet.<digits>.<label|group|type>" key
+ */
+static ExtAttributeKey s_outlet(std::string_view key) noexcept
+{
+    static const std::string_view prefix = "outlet.";
+    if (key.compare(0, prefix.size(), prefix) != 0) {
+        return OTHER;
+    }
+    std::string_view rest = key.substr(prefix.size());
+    size_t           n    = s_digits(rest);
+    if (n == 0 || n == rest.size() || rest[n] != '.') {
+        return OTHER;
+    }
+    std::string_view suffix = rest.substr(n + 1);
+    if (suffix == "label") {
+        return {ExtAttributeKind::OutletLabel, rest.substr(0, n)};
+    }
+    if (suffix == "group") {
+        return {ExtAttributeKind::OutletGroup, rest.substr(0, n)};
+    }
+    if (suffix == "type") {
+        return {ExtAttributeKind::OutletType, rest.substr(0, n)};
+    }
+    return OTHER;
+}
+
+ExtAttributeKey classifyExtAttribute(std::string_view key) noexcept
+{
+    // first character decides which pattern can match at all, most keys are rejected here
+    if (key.empty()) {
+        return OTHER;
+    }
+    switch (key[0]) {
+        case 'o':
+            return s_outlet(key);
+        case 'i':
+            return s_numbered(key, "ip", ExtAttributeKind::Ip);
+        case 'm':
+            return s_numbered(key, "mac", ExtAttributeKind::Mac);
+        case 'h':
+            return s_numbered(key, "hostname", ExtAttributeKind::Hostname);
+        case 'f':
+            return s_numbered(key, "fqdn", ExtAttributeKind::Fqdn);
+        default:
+            return OTHER;
+    }
+}
+
+void addOutletAttribute(Outlets& outlets, const ExtAttributeKey& key, const std::string& value, bool read_only)
+{
+    auto it = outlets.find(key.number);
+    if (it == outlets.end()) {
+        it = outlets.emplace(std::string(key.number), Outlet()).first;
+    }
+    switch (key.kind) {
+        case ExtAttributeKind::OutletLabel:
+            it->second.label   = value;
+            it->second.label_r = read_only;
+            break;
+        case ExtAttributeKind::OutletGroup:
+            it->second.group   = value;
+            it->second.group_r = read_only;
+            break;
+        case ExtAttributeKind::OutletType:
+            it->second.type   = value;
+            it->second.type_r = read_only;
+            break;
+        default:
+            break;
+    }
+}
+
+} // namespace shared
@@ -0,0 +1,81 @@
+/*
+Copyright (C) 2015 - 2020 Eaton
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+/// \file ext_attribute.h
+/// \brief Classification of ext attribute keys for asset serializers
+///
+/// Some ext attributes are not printed as "ext" but grouped, outlets by their number and the numbered network
+/// ones into lists. The key is classified by one pass over its characters, which accepts the same keys as
+///  * ^outlet\.[0-9][0-9]*\.(label|group|type)$
+///  * ^(ip|mac|hostname|fqdn)\.[0-9][0-9]*$
+/// and gives the number as a view into the key, so nothing is allocated.
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+
+namespace shared {
+
+enum class ExtAttributeKind
+{
+    Other,
+    OutletLabel,
+    OutletGroup,
+    OutletType,
+    Ip,
+    Mac,
+    Hostname,
+    Fqdn
+};
+
+struct ExtAttributeKey
+{
+    ExtAttributeKind kind;
+    /// digits of the key, outlet number for outlets, empty for Other; points into the classified key
+    std::string_view number;
+};
+
+/// return kind and number of ext attribute key
+ExtAttributeKey classifyExtAttribute(std::string_view key) noexcept;
+
+/// outlet ext attributes of one asset
+struct Outlet
+{
+    std::string label;
+    bool        label_r = false;
+    std::string type;
+    bool        type_r = false;
+    std::string group;
+    bool        group_r = false;
+};
+
+/// outlets by number, looked up by the number view without building a key
+using Outlets = std::map<std::string, Outlet, std::less<>>;
+
+/// Stores outlet ext attribute to its outlet
+///
+/// @param[in,out] outlets   - outlets of the asset, the outlet is added when not present yet
+/// @param[in]     key       - classified key, must be one of outlet kinds
+/// @param[in]     value     - value of the attribute
+/// @param[in]     read_only - read only flag of the attribute
+void addOutletAttribute(Outlets& outlets, const ExtAttributeKey& key, const std::string& value, bool read_only);
+
+} // namespace shared
@@ -0,0 +1,220 @@
+/*
+Copyright (C) 2015 - 2020 Eaton
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+/// \file lru_cache.h
+/// \brief Bounded, thread safe key/value cache with least recently used eviction
+///
+/// Keys are spread over shards by their hash, every shard has its own lock, recency list and an equal part of the
+/// capacity, so concurrent lookups of different keys rarely wait for each other. A full shard evicts its least
+/// recently used entry, never everything at once. Entries may expire after a TTL, an expired entry is dropped when
+/// it is looked up. Hits, misses, evictions and expirations are counted for the whole cache.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace shared {
+
+/// Counters of a cache since it was created
+struct CacheStats
+{
+    uint64_t hits        = 0;
+    uint64_t misses      = 0; // expired entries included
+    uint64_t evictions   = 0; // entries dropped to make room
+    uint64_t expirations = 0;
+    size_t   size        = 0;
+};
+
+/// @class LruCache
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class LruCache
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// Creates empty cache
+    ///
+    /// @param[in] capacity - entries kept at most, split evenly among shards
+    /// @param[in] ttl      - time an entry is valid for after it was stored, zero for no expiration
+    /// @param[in] shards   - number of independently locked parts
+    explicit LruCache(size_t capacity, Clock::duration ttl = Clock::duration::zero(), size_t shards = 16)
+        : _shards(shards ? shards : 1)
+        , _shard_capacity{(capacity + _shards.size() - 1) / _shards.size()}
+        , _ttl{ttl}
+    {
+        if (_shard_capacity == 0) {
+            _shard_capacity = 1;
+        }
+    }
+
+    LruCache(const LruCache&) = delete;
+    LruCache& operator=(const LruCache&) = delete;
+
+    /// Finds the entry and marks it as most recently used
+    ///
+    /// @return false if there is no valid entry of the key
+    bool get(const Key& key, Value& value)
+    {
+        Shard&                      shard = shard_of(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto                        it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            ++_misses;
+            return false;
+        }
+        if (expired(*it->second)) {
+            shard.entries.erase(it->second);
+            shard.index.erase(it);
+            ++_expirations;
+            ++_misses;
+            return false;
+        }
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        value = it->second->value;
+        ++_hits;
+        return true;
+    }
+
+    /// return if there is a valid entry of the key, recency and counters are not changed
+    bool contains(const Key& key) const
+    {
+        const Shard&                shard = shard_of(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto                        it = shard.index.find(key);
+        return it != shard.index.end() && !expired(*it->second);
+    }
+
+    /// Stores the entry as most recently used, the least recently used one of the shard is evicted if it is full
+    void put(const Key& key, Value value)
+    {
+        Shard&                      shard = shard_of(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto                        it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            it->second->value   = std::move(value);
+            it->second->expires = expiration();
+            shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+            return;
+        }
+        if (shard.index.size() >= _shard_capacity) {
+            shard.index.erase(shard.entries.back().key);
+            shard.entries.pop_back();
+            ++_evictions;
+        }
+        shard.entries.push_front(Entry{key, std::move(value), expiration()});
+        shard.index.emplace(key, shard.entries.begin());
+    }
+
+    /// Drops the entry, return false if there was none
+    bool erase(const Key& key)
+    {
+        Shard&                      shard = shard_of(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto                        it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            return false;
+        }
+        shard.entries.erase(it->second);
+        shard.index.erase(it);
+        return true;
+    }
+
+    void clear()
+    {
+        for (auto& shard : _shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.index.clear();
+            shard.entries.clear();
+        }
+    }
+
+    /// return counters and number of entries, expired ones not looked up yet included
+    CacheStats stats() const
+    {
+        CacheStats stats;
+        stats.hits        = _hits;
+        stats.misses      = _misses;
+        stats.evictions   = _evictions;
+        stats.expirations = _expirations;
+        for (const auto& shard : _shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            stats.size += shard.index.size();
+        }
+        return stats;
+    }
+
+private:
+    struct Entry
+    {
+        Key               key;
+        Value             value;
+        Clock::time_point expires;
+    };
+
+    struct Shard
+    {
+        mutable std::mutex                                                 mutex;
+        std::list<Entry>                                                   entries; // most recently used first
+        std::unordered_map<Key, typename std::list<Entry>::iterator, Hash> index;
+    };
+
+    Shard& shard_of(const Key& key)
+    {
+        return _shards[shard_index(key)];
+    }
+
+    const Shard& shard_of(const Key& key) const
+    {
+        return _shards[shard_index(key)];
+    }
+
+    size_t shard_index(const Key& key) const
+    {
+        // maps of shards use the same hash, shard is chosen by its mixed high bits so the low ones stay spread
+        uint64_t hash = uint64_t(Hash()(key)) * 0x9e3779b97f4a7c15ull;
+        return size_t(hash >> 40) % _shards.size();
+    }
+
+    Clock::time_point expiration() const
+    {
+        return _ttl == Clock::duration::zero() ? Clock::time_point::max() : Clock::now() + _ttl;
+    }
+
+    bool expired(const Entry& entry) const
+    {
+        return entry.expires != Clock::time_point::max() && Clock::now() >= entry.expires;
+    }
+
+    std::vector<Shard>    _shards;
+    size_t                _shard_capacity;
+    Clock::duration       _ttl;
+    std::atomic<uint64_t> _hits{0};
+    std::atomic<uint64_t> _misses{0};
+    std::atomic<uint64_t> _evictions{0};
+    std::atomic<uint64_t> _expirations{0};
+};
+
+} // namespace shared
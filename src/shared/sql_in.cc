@@ -0,0 +1,39 @@
+/*
+Copyright (C) 2015 - 2020 Eaton
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "shared/sql_in.h"
+
+namespace shared {
+
+std::string sql_in_placeholders(size_t n)
+{
+    std::string ret;
+    for (size_t i = 0; i != n; ++i) {
+        ret += (i ? ", :n" : ":n") + std::to_string(i);
+    }
+    return ret;
+}
+
+void sql_in_bind(tntdb::Statement& st, const std::vector<std::string>& values)
+{
+    for (size_t i = 0; i != values.size(); ++i) {
+        st.set("n" + std::to_string(i), values[i]);
+    }
+}
+
+} // namespace shared
@@ -0,0 +1,78 @@
+/*
+Copyright (C) 2015 - 2020 Eaton
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+/// @file   sql_in.h
+/// @brief  Lists of values for SQL IN (...) conditions
+///
+/// Long lists are split into chunks, so a statement stays reasonably long whatever the number of values. Ids are
+/// inlined, names are bound to placeholders :n0, :n1, ... of one chunk.
+
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <tntdb/statement.h>
+#include <vector>
+
+namespace shared {
+
+/// values put into one IN (...)
+static constexpr size_t SQL_IN_CHUNK = 1000;
+
+/// Splits ids into comma separated lists of at most chunk ids, one per IN (...)
+///
+/// @param[in] ids - container of integral ids, in the order they are listed
+/// @return lists "1, 2, 3", none if there are no ids
+template <typename Ids>
+std::vector<std::string> sql_in_lists(const Ids& ids, size_t chunk = SQL_IN_CHUNK)
+{
+    std::vector<std::string> lists;
+    size_t                   count = 0;
+    for (const auto& id : ids) {
+        if (count++ % chunk == 0) {
+            lists.emplace_back();
+        } else {
+            lists.back() += ", ";
+        }
+        lists.back() += std::to_string(id);
+    }
+    return lists;
+}
+
+/// Splits values into chunks of at most chunk values, each is bound by sql_in_bind
+template <typename Values>
+std::vector<std::vector<std::string>> sql_in_chunks(const Values& values, size_t chunk = SQL_IN_CHUNK)
+{
+    std::vector<std::vector<std::string>> chunks;
+    for (const auto& value : values) {
+        if (chunks.empty() || chunks.back().size() == chunk) {
+            chunks.emplace_back();
+            chunks.back().reserve(std::min(chunk, size_t(values.size())));
+        }
+        chunks.back().push_back(value);
+    }
+    return chunks;
+}
+
+/// return placeholders ":n0, :n1, ..." of n values
+std::string sql_in_placeholders(size_t n);
+
+/// Binds values to the placeholders given by sql_in_placeholders(values.size())
+void sql_in_bind(tntdb::Statement& st, const std::vector<std::string>& values);
+
+} // namespace shared
@@ -24,23 +24,19 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 
 #pragma once
 
-#include <map>
-#include <set>
+#include "shared/lru_cache.h"
 #include <string>
 
 namespace persist {
 
-class TopicCache
+/// Topic ids by topic name, least recently used topics are evicted once max is reached
+class TopicCache : public shared::LruCache<std::string, int>
 {
 public:
     explicit TopicCache(size_t max = 8 * 1024)
-        : _cache{}
-        , _max{max} {};
+        : LruCache{max} {};
 
-    TopicCache(const TopicCache& other)  = delete;
-    TopicCache(const TopicCache&& other) = delete;
-    TopicCache& operator=(TopicCache& other) = delete;
-    TopicCache& operator=(TopicCache&& other) = delete;
+    using LruCache::get;
 
     /// check if value is in cache or not
     bool has(const std::string& topic_name) const;
@@ -50,10 +46,6 @@ public:
 
     /// get topic_id vs topic_name, return 0 when not found
     int get(const std::string& topic_name);
-
-private:
-    std::map<std::string, int> _cache;
-    size_t                     _max;
 };
 
 } // namespace persist
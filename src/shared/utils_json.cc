@@ -19,36 +19,22 @@
  */
 
 #include "shared/utils_json.h"
+#include "persist/assetnames.h"
+#include "shared/asset_json_cache.h"
 #include "shared/data.h"
+#include "shared/ext_attribute.h"
+#include "shared/sql_in.h"
 #include "shared/utils.h"
 #include "shared/utilspp.h"
 #include "web/src/asset_computed_impl.h"
 #include <cmath>
 #include <fty_common.h>
 #include <fty_common_db_asset.h>
+#include <fty_common_db_dbpath.h>
 #include <fty_common_rest.h>
 #include <fty_proto.h>
 #include <fty_shm.h>
-#include <regex>
-
-struct Outlet
-{
-    std::string label;
-    bool        label_r;
-    std::string type;
-    bool        type_r;
-    std::string group;
-    bool        group_r;
-};
-
-std::string getOutletNumber(const std::string& extAttributeName)
-{
-    auto        dot1    = extAttributeName.find_first_of(".");
-    std::string oNumber = extAttributeName.substr(dot1 + 1);
-    auto        dot2    = oNumber.find_first_of(".");
-    oNumber             = oNumber.substr(0, dot2);
-    return oNumber;
-}
+#include <set>
 
 // encode metric GET request
 
@@ -165,8 +151,9 @@ std::string getJsonAlert(tntdb::Connection connection, fty_proto_t* alert)
         return json;
     }
 
-    log_debug("DBAssets::id_to_name_ext_name ('%d')", asset_element.item.id);
-    std::pair<std::string, std::string> asset_element_names = DBAssets::id_to_name_ext_name(asset_element.item.id);
+    log_debug("persist::AssetNames::id_to_name_ext_name ('%d')", asset_element.item.id);
+    std::pair<std::string, std::string> asset_element_names =
+        persist::AssetNames::id_to_name_ext_name(asset_element.item.id);
     if (asset_element_names.first.empty() && asset_element_names.second.empty()) {
         log_error("internal-error : Database error");
         return json;
@@ -190,29 +177,82 @@ std::string getJsonAlert(tntdb::Connection connection, fty_proto_t* alert)
     return json;
 }
 
-std::string getJsonAsset(mlm_client_t* clientMlm, int64_t elemId)
+namespace {
+
+// names and type of asset referenced by asset json
+struct ReferencedAsset
 {
-    std::string json;
-    // Get informations from database
-    asset_manager asset_mgr;
-    auto          tmp = asset_mgr.get_item1(uint32_t(elemId));
-    if (tmp.status == 0) {
-        switch (tmp.errsubtype) {
-            case DB_ERROR_NOTFOUND:
-                log_error("element-not-found : %" PRId64 "", elemId);
-            case DB_ERROR_BADINPUT:
-            case DB_ERROR_INTERNAL:
-            default:
-                log_error("get_item1 Internal database error");
+    std::string name;
+    std::string ext_name;
+    std::string type_name;
+};
+
+} // namespace
+
+typedef std::map<uint32_t, ReferencedAsset> asset_names_t;
+
+/*
+ * \brief Collects ids of all assets the json of the asset refers to, the asset itself included
+ */
+static void s_referenced_ids(const db_web_element_t& item, std::set<uint32_t>& ids)
+{
+    ids.insert(item.basic.id);
+    if (item.basic.parent_id != 0) {
+        ids.insert(item.basic.parent_id);
+    }
+    for (const auto& oneGroup : item.groups) {
+        ids.insert(oneGroup.first);
+    }
+    for (const auto& oneLink : item.powers) {
+        ids.insert(oneLink.src_id);
+    }
+    for (const auto& it : item.parents) {
+        ids.insert(std::get<0>(it));
+    }
+}
+
+/*
+ * \brief Reads names, external names and types of given assets, one query per chunk of ids
+ */
+static void s_select_names(tntdb::Connection& conn, const std::set<uint32_t>& ids, asset_names_t& names)
+{
+    for (const auto& in : shared::sql_in_lists(ids)) {
+        for (const auto& row : conn.prepare(" SELECT v.id, v.name, e.value, v.type_name"
+                                            " FROM v_web_element v"
+                                            " LEFT JOIN t_bios_asset_ext_attributes e"
+                                            "   ON e.id_asset_element = v.id AND e.keytag = 'name'"
+                                            " WHERE v.id IN (" + in + ")")
+                                   .select()) {
+            ReferencedAsset& asset = names[row.getUnsigned32(0)];
+            row[1].get(asset.name);
+            row[2].get(asset.ext_name);
+            row[3].get(asset.type_name);
         }
-        return json;
     }
+}
 
-    std::pair<std::string, std::string> parent_names    = DBAssets::id_to_name_ext_name(tmp.item.basic.parent_id);
+/*
+ * \brief Name and external name of the asset, both empty if not found, like DBAssets::id_to_name_ext_name
+ */
+static std::pair<std::string, std::string> s_name_ext_name(const asset_names_t& names, uint32_t id)
+{
+    auto it = names.find(id);
+    if (it == names.end()) {
+        return {};
+    }
+    return {it->second.name, it->second.ext_name};
+}
+
+static std::string s_asset_json(
+    tntdb::Connection& conn, mlm_client_t* clientMlm, db_reply<db_web_element_t>& tmp, const asset_names_t& names)
+{
+    std::string json;
+
+    std::pair<std::string, std::string> parent_names    = s_name_ext_name(names, tmp.item.basic.parent_id);
     std::string                         parent_name     = parent_names.first;
     std::string                         ext_parent_name = parent_names.second;
 
-    std::pair<std::string, std::string> asset_names = DBAssets::id_to_name_ext_name(tmp.item.basic.id);
+    std::pair<std::string, std::string> asset_names = s_name_ext_name(names, tmp.item.basic.id);
     if (asset_names.first.empty() && asset_names.second.empty()) {
         log_error("Database failure");
         return json;
@@ -236,9 +276,9 @@ std::string getJsonAsset(mlm_client_t* clientMlm, int64_t elemId)
         json += utils::json::jsonify("location_id", parent_name) + ",";
         json += utils::json::jsonify("location", ext_parent_name) + ",";
 
-        // Get informations from database
-        auto parentAsset = asset_mgr.get_item1(tmp.item.basic.parent_id);
-        json += utils::json::jsonify("location_type", parentAsset.item.basic.type_name) + ",";
+        // type of the parent was read together with the names
+        auto parent = names.find(tmp.item.basic.parent_id);
+        json += utils::json::jsonify("location_type", parent != names.end() ? parent->second.type_name : "") + ",";
     } else {
         json += "\"location\":\"\",";
         json += "\"location_type\":\"\",";
@@ -251,7 +291,7 @@ std::string getJsonAsset(mlm_client_t* clientMlm, int64_t elemId)
         uint32_t    i           = 1;
         std::string ext_name    = "";
         for (auto& oneGroup : tmp.item.groups) {
-            std::pair<std::string, std::string> group_names = DBAssets::id_to_name_ext_name(oneGroup.first);
+            std::pair<std::string, std::string> group_names = s_name_ext_name(names, oneGroup.first);
             if (group_names.first.empty() && group_names.second.empty()) {
                 log_error("Database failure");
                 json = "";
@@ -279,7 +319,7 @@ std::string getJsonAsset(mlm_client_t* clientMlm, int64_t elemId)
             uint32_t power_count = uint32_t(tmp.item.powers.size());
             uint32_t i           = 1;
             for (auto& oneLink : tmp.item.powers) {
-                std::pair<std::string, std::string> link_names = DBAssets::id_to_name_ext_name(oneLink.src_id);
+                std::pair<std::string, std::string> link_names = s_name_ext_name(names, oneLink.src_id);
                 if (link_names.first.empty() && link_names.second.empty()) {
                     log_error("Database failure");
                     json = "";
@@ -323,7 +363,7 @@ std::string getJsonAsset(mlm_client_t* clientMlm, int64_t elemId)
 
         for (const auto& it : tmp.item.parents) {
             char                                comma    = i != tmp.item.parents.size() ? ',' : ' ';
-            std::pair<std::string, std::string> it_names = DBAssets::id_to_name_ext_name(std::get<0>(it));
+            std::pair<std::string, std::string> it_names = s_name_ext_name(names, std::get<0>(it));
             if (it_names.first.empty() && it_names.second.empty()) {
                 log_error("Database failure");
                 json = "";
@@ -352,19 +392,12 @@ std::string getJsonAsset(mlm_client_t* clientMlm, int64_t elemId)
         isExtCommaNeeded = true;
     }
 
-    std::map<std::string, Outlet> outlets;
-    std::vector<std::string>      ips;
-    std::vector<std::string>      macs;
-    std::vector<std::string>      fqdns;
-    std::vector<std::string>      hostnames;
+    shared::Outlets          outlets;
+    std::vector<std::string> ips;
+    std::vector<std::string> macs;
+    std::vector<std::string> fqdns;
+    std::vector<std::string> hostnames;
     if (!tmp.item.ext.empty()) {
-        std::regex r_outlet_label("^outlet\\.[0-9][0-9]*\\.label$");
-        std::regex r_outlet_group("^outlet\\.[0-9][0-9]*\\.group$");
-        std::regex r_outlet_type("^outlet\\.[0-9][0-9]*\\.type$");
-        std::regex r_ip("^ip\\.[0-9][0-9]*$");
-        std::regex r_mac("^mac\\.[0-9][0-9]*$");
-        std::regex r_hostname("^hostname\\.[0-9][0-9]*$");
-        std::regex r_fqdn("^fqdn\\.[0-9][0-9]*$");
         for (auto& oneExt : tmp.item.ext) {
             auto& attrName = oneExt.first;
 
@@ -377,48 +410,27 @@ std::string getJsonAsset(mlm_client_t* clientMlm, int64_t elemId)
 
             auto& attrValue  = oneExt.second.first;
             auto  isReadOnly = oneExt.second.second;
-            if (std::regex_match(attrName, r_outlet_label)) {
-                auto oNumber = getOutletNumber(attrName);
-                auto it      = outlets.find(oNumber);
-                if (it == outlets.cend()) {
-                    auto r = outlets.emplace(oNumber, Outlet());
-                    it     = r.first;
-                }
-                it->second.label   = attrValue;
-                it->second.label_r = isReadOnly;
-                continue;
-            } else if (std::regex_match(attrName, r_outlet_group)) {
-                auto oNumber = getOutletNumber(attrName);
-                auto it      = outlets.find(oNumber);
-                if (it == outlets.cend()) {
-                    auto r = outlets.emplace(oNumber, Outlet());
-                    it     = r.first;
-                }
-                it->second.group   = attrValue;
-                it->second.group_r = isReadOnly;
-                continue;
-            } else if (std::regex_match(attrName, r_outlet_type)) {
-                auto oNumber = getOutletNumber(attrName);
-                auto it      = outlets.find(oNumber);
-                if (it == outlets.cend()) {
-                    auto r = outlets.emplace(oNumber, Outlet());
-                    it     = r.first;
-                }
-                it->second.type   = attrValue;
-                it->second.type_r = isReadOnly;
-                continue;
-            } else if (std::regex_match(attrName, r_ip)) {
-                ips.push_back(attrValue);
-                continue;
-            } else if (std::regex_match(attrName, r_mac)) {
-                macs.push_back(attrValue);
-                continue;
-            } else if (std::regex_match(attrName, r_fqdn)) {
-                fqdns.push_back(attrValue);
-                continue;
-            } else if (std::regex_match(attrName, r_hostname)) {
-                hostnames.push_back(attrValue);
-                continue;
+            auto  key        = shared::classifyExtAttribute(attrName);
+            switch (key.kind) {
+                case shared::ExtAttributeKind::OutletLabel:
+                case shared::ExtAttributeKind::OutletGroup:
+                case shared::ExtAttributeKind::OutletType:
+                    shared::addOutletAttribute(outlets, key, attrValue, isReadOnly);
+                    continue;
+                case shared::ExtAttributeKind::Ip:
+                    ips.push_back(attrValue);
+                    continue;
+                case shared::ExtAttributeKind::Mac:
+                    macs.push_back(attrValue);
+                    continue;
+                case shared::ExtAttributeKind::Fqdn:
+                    fqdns.push_back(attrValue);
+                    continue;
+                case shared::ExtAttributeKind::Hostname:
+                    hostnames.push_back(attrValue);
+                    continue;
+                case shared::ExtAttributeKind::Other:
+                    break;
             }
             // If we are here -> then this attribute is not special and should be returned as "ext"
             std::string extKey = oneExt.first;
@@ -550,7 +562,7 @@ std::string getJsonAsset(mlm_client_t* clientMlm, int64_t elemId)
 
     json += ", \"computed\" : {";
     if (persist::is_rack(tmp.item.basic.type_id)) {
-        int    freeusize         = free_u_size(tmp.item.basic.id);
+        int    freeusize         = free_u_size(conn, tmp.item.basic.id);
         double realpower_nominal = s_rack_realpower_nominal(clientMlm, tmp.item.basic.name.c_str());
 
         json += "\"freeusize\":" + (freeusize >= 0 ? std::to_string(freeusize) : "null");
@@ -558,7 +570,7 @@ std::string getJsonAsset(mlm_client_t* clientMlm, int64_t elemId)
             ",\"realpower.nominal\":" + (!std::isnan(realpower_nominal) ? std::to_string(realpower_nominal) : "null");
         json += ", \"outlet.available\" : {";
         std::map<std::string, int> res;
-        int                        rv = rack_outlets_available(tmp.item.basic.id, res);
+        int                        rv = rack_outlets_available(conn, tmp.item.basic.id, res);
         if (rv != 0) {
             log_error("Database failure");
             json = "";
@@ -580,3 +592,82 @@ std::string getJsonAsset(mlm_client_t* clientMlm, int64_t elemId)
     json += "}}";
     return json;
 }
+
+std::map<int64_t, std::string> getJsonAssets(
+    tntdb::Connection& conn, mlm_client_t* clientMlm, const std::vector<int64_t>& elemIds)
+{
+    std::map<int64_t, std::string> ret;
+
+    // changes from now on make what is read below outdated
+    auto&    cache    = shared::AssetJsonCache::instance();
+    uint64_t revision = cache.revision();
+
+    // Get informations from database
+    asset_manager                                               asset_mgr;
+    std::vector<std::pair<int64_t, db_reply<db_web_element_t>>> items;
+    std::set<uint32_t>                                          referenced;
+    for (int64_t elemId : elemIds) {
+        if (cache.find(uint32_t(elemId), ret[elemId])) {
+            continue;
+        }
+        auto tmp = asset_mgr.get_item1(conn, uint32_t(elemId));
+        if (tmp.status == 0) {
+            switch (tmp.errsubtype) {
+                case DB_ERROR_NOTFOUND:
+                    log_error("element-not-found : %" PRId64 "", elemId);
+                case DB_ERROR_BADINPUT:
+                case DB_ERROR_INTERNAL:
+                default:
+                    log_error("get_item1 Internal database error");
+            }
+            continue;
+        }
+        s_referenced_ids(tmp.item, referenced);
+        items.emplace_back(elemId, std::move(tmp));
+    }
+    if (items.empty()) {
+        return ret;
+    }
+
+    // names of all assets, their parents, groups and power sources at once
+    asset_names_t names;
+    try {
+        s_select_names(conn, referenced, names);
+    } catch (const std::exception& e) {
+        log_error("Database failure: %s", e.what());
+        return ret;
+    }
+
+    for (auto& it : items) {
+        std::string json = s_asset_json(conn, clientMlm, it.second, names);
+        // computed values of racks depend on their content and metrics, they are always rendered
+        if (!json.empty() && !persist::is_rack(it.second.item.basic.type_id)) {
+            std::set<uint32_t> ids;
+            s_referenced_ids(it.second.item, ids);
+            std::vector<std::pair<uint32_t, std::string>> depends;
+            for (uint32_t id : ids) {
+                depends.emplace_back(id, names[id].name);
+            }
+            cache.store(uint32_t(it.first), revision, json, depends);
+        }
+        ret[it.first] = std::move(json);
+    }
+    return ret;
+}
+
+std::string getJsonAsset(mlm_client_t* clientMlm, int64_t elemId)
+{
+    std::string json;
+    if (shared::AssetJsonCache::instance().find(uint32_t(elemId), json)) {
+        return json;
+    }
+
+    tntdb::Connection conn;
+    try {
+        conn = tntdb::connect(DBConn::url);
+    } catch (const std::exception& e) {
+        log_error("get_item1 Internal database error: %s", e.what());
+        return json;
+    }
+    return getJsonAssets(conn, clientMlm, {elemId})[elemId];
+}
@@ -28,7 +28,9 @@
 
 #include <malamute.h>
 #include <fty_proto.h>
+#include <map>
 #include <string>
+#include <vector>
 #include <tntdb.h>
 
 //Return an alert with a json format
@@ -37,5 +39,10 @@ std::string getJsonAlert(tntdb::Connection connection, fty_proto_t *alert);
 //Return an Asset with a json format
 std::string getJsonAsset(mlm_client_t * clientMlm, int64_t elemId);
 
+//Return Assets with a json format, names of all referenced assets are read at once on given connection;
+//asset which can't be read maps to empty string, as getJsonAsset returns
+std::map<int64_t, std::string> getJsonAssets(
+    tntdb::Connection& conn, mlm_client_t * clientMlm, const std::vector<int64_t>& elemIds);
+
 
 #endif // SRC_SHARED_WEB_UTILS_H_
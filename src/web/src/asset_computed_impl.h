@@ -25,7 +25,13 @@
 
 #include <map>
 #include <string>
+#include <tntdb/connection.h>
 
 int free_u_size(uint32_t elementId);
 
+/// same as above on given connection, so more assets can be computed without connecting again
+int free_u_size(tntdb::Connection& conn, uint32_t elementId);
+
 int rack_outlets_available(uint32_t elementId, std::map<std::string, int>& res);
+
+int rack_outlets_available(tntdb::Connection& conn, uint32_t elementId, std::map<std::string, int>& res);
@@ -29,7 +29,10 @@
 
 #include "web/src/sse.h"
 #include "shared/data.h"
+#include "shared/asset_json_cache.h"
 #include "shared/utils_json.h"
+#include "persist/assetnames.h"
+#include "persist/assettree.h"
 
 //constructor
 
@@ -153,22 +156,12 @@ std::string Sse::loadAssetFromDatacenter()
 
   try
   {
-    int rv = DBAssets::select_assets_by_container(_connection, _datacenter_id,
-      [&assets](const tntdb::Row & row) -> void
-      {
-        std::string name;
-        row[0].get(name);
-        assets.emplace(std::make_pair(name, 5));
-      });
-    if (rv != 0)
+    auto ids = persist::AssetTree::instance().descendants(_datacenter_id);
+    for (auto& name : persist::AssetNames::id_to_name(ids))
     {
-      return TRANSLATE_ME ("DBAssets::select_assets_by_container () failed.");
+      assets.emplace(std::make_pair(std::move(name), 5));
     }
   }
-  catch (const tntdb::Error& e)
-  {
-    return JSONIFY (e.what());
-  }
   catch (const std::exception& e)
   {
     return JSONIFY (e.what());
@@ -254,6 +247,10 @@ std::string Sse::changeFtyProtoAsset2Json(fty_proto_t *asset)
 {
   log_debug("SSE FtyProto asset message (name: %s, operation: %s)", fty_proto_name(asset), fty_proto_operation(asset));
 
+  // the listener of the cache may not have seen the message yet; other sessions with the same message don't
+  // invalidate it again, so the asset is rendered once for all of them
+  shared::AssetJsonCache::instance().invalidate(asset);
+
   //return value
   std::string json = "";
 
@@ -360,7 +357,7 @@ std::string Sse::changeFtyProtoAsset2Json(fty_proto_t *asset)
     }
 
     //get id of this element
-    int64_t elemId = DBAssets::name_to_asset_id(nameElement);
+    int64_t elemId = persist::AssetNames::name_to_asset_id(nameElement);
     if (elemId == -1)
     {
       log_warning("Asset id not found");
@@ -426,6 +423,24 @@ std::string Sse::changeSseMessage2Json(zmsg_t *message)
 
 bool Sse::isAssetInDatacenter(fty_proto_t *asset)
 {
+  // parent is known before its new children are, the asset itself may not be in the tree yet
+  uint32_t parent = uint32_t(fty_proto_aux_number(asset, "parent", 0));
+  try
+  {
+    auto& tree = persist::AssetTree::instance();
+    if (parent != 0 && tree.known(parent))
+    {
+      bool found = parent == _datacenter_id || tree.contains(_datacenter_id, parent);
+      log_debug("Sse : Asset %s found",found ? "":"not");
+      return found;
+    }
+  }
+  catch (const std::exception& e)
+  {
+    log_warning("asset tree not available: %s", e.what());
+  }
+
+  // parent created elsewhere and not announced yet, the message carries names of all its ancestors
   int i = 1;
   const char * parentName = fty_proto_aux_string(asset, ("parent_name." + std::to_string(i)).c_str(), "not found");
   bool found = streq(parentName, _datacenter.c_str());